@@ -1,12 +1,23 @@
 #pragma once
 
 #include <cassert>
+#include <cstdint>
+#include <new>
 #include <string>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define A3D_X86 1
+#endif
+
 #define LOGD(x, ...) printf(x "\n", __VA_ARGS__)
 #define LOGDD(x) printf(x "\n")
 
 using u8 = uint8_t;
+using u16 = uint16_t;
 using u32 = uint32_t;
 using u64 = uint64_t;
 
@@ -77,5 +88,58 @@ struct color_t
   u8 b, g, r, a;
 };
 
+/* per channel blend of two packed colors, weight goes from 0 (only a) to 256 (only b) */
+inline u32 blendColors(u32 a, u32 b, u32 weight)
+{
+  const u32 inverse = 256 - weight;
+  const u32 rb = (((a & 0x00FF00FF) * inverse + (b & 0x00FF00FF) * weight + 0x00800080) >> 8) & 0x00FF00FF;
+  const u32 ag = ((((a >> 8) & 0x00FF00FF) * inverse + ((b >> 8) & 0x00FF00FF) * weight + 0x00800080)) & 0xFF00FF00;
+  return rb | ag;
+}
+
 using path = std::string;
 
+/* index of the lowest set bit, value must not be 0 */
+inline u32 countTrailingZeros(u32 value)
+{
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, value);
+  return index;
+#else
+  return __builtin_ctz(value);
+#endif
+}
+
+/* number of set bits */
+inline u32 countBits(u32 value)
+{
+#if defined(_MSC_VER)
+  return __popcnt(value);
+#else
+  return __builtin_popcount(value);
+#endif
+}
+
+
+/* allocator for standard containers which aligns their storage, eg. to the width of SIMD registers */
+template<typename T, size_t Alignment>
+struct aligned_allocator
+{
+  using value_type = T;
+
+  template<typename U>
+  struct rebind { using other = aligned_allocator<U, Alignment>; };
+
+  aligned_allocator() = default;
+  template<typename U>
+  aligned_allocator(const aligned_allocator<U, Alignment>&) { }
+
+  T* allocate(size_t count) { return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(Alignment))); }
+  void deallocate(T* pointer, size_t) { ::operator delete(pointer, std::align_val_t(Alignment)); }
+
+  template<typename U>
+  bool operator==(const aligned_allocator<U, Alignment>&) const { return true; }
+  template<typename U>
+  bool operator!=(const aligned_allocator<U, Alignment>&) const { return false; }
+};
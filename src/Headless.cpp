@@ -0,0 +1,98 @@
+#include "Headless.h"
+
+#include "gfx/DemoScene.h"
+#include "gfx/FrameRecorder.h"
+#include "gfx/FrameSink.h"
+#include "gfx/SdlHelper.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace a3d;
+
+int headless::run(int argc, char* argv[])
+{
+  std::vector<const char*> arguments;
+  PixelFormat pixelFormat = PixelFormat::ARGB8888;
+  bool valid = true;
+
+  for (int i = 0; i < argc; ++i)
+  {
+    if (strcmp(argv[i], "--format") == 0)
+      valid &= i + 1 < argc && pixels::fromName(argv[++i], pixelFormat);
+    else
+      arguments.push_back(argv[i]);
+  }
+
+  const long frames = arguments.size() > 0 ? strtol(arguments[0], nullptr, 10) : 1;
+  const char* output = arguments.size() > 1 ? arguments[1] : nullptr;
+
+  ImageFormat format = ImageFormat::PPM;
+
+  if (!valid || frames <= 0 || (output && !images::formatFor(output, format)))
+  {
+    printf("Usage: --headless [frames] [output.ppm|output.png|output.y4m] [--format argb8888|rgba8888]\n");
+    return -1;
+  }
+
+  /* before the scene loads its textures and the target is created */
+  pixels::setFormat(pixelFormat);
+
+  ThreadPool pool;
+  DemoScene scene(&pool);
+  RenderTarget target(WIDTH, HEIGHT);
+  MemorySink sink(WIDTH, HEIGHT);
+
+  /* video gets every frame, nothing is dropped since there's no one waiting for them */
+  FrameRecorder recorder;
+  const bool video = output && format == ImageFormat::Y4M;
+
+  if (video && !recorder.start(path(output).substr(0, strlen(output) - 4), format, target, 8, FrameRecorder::Policy::STALL))
+  {
+    printf("Error while creating %s.\n", output);
+    return -1;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+
+  for (long i = 0; i < frames; ++i)
+  {
+    sink.begin(target);
+    scene.render(target);
+    recorder.capture(target);
+    sink.end(target);
+  }
+
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("%llu frames at %dx%d in %.3f s, %.1f frames/s\n", (unsigned long long)sink.frames(), WIDTH, HEIGHT, seconds, sink.frames() / seconds);
+
+  if (video)
+  {
+    recorder.stop();
+
+    const auto stats = recorder.stats();
+    printf("%llu frames written, %llu stalls\n", (unsigned long long)stats.written, (unsigned long long)stats.stalls);
+
+    if (stats.failed)
+    {
+      printf("Error while writing %s.\n", output);
+      return -1;
+    }
+  }
+  else if (output)
+  {
+    const image_view_t image = { sink.data(), size_t(sink.width()), sink.width(), sink.height(), target.format() };
+    const bool success = format == ImageFormat::PNG ? images::writePng(output, image) : images::writePpm(output, image);
+
+    if (!success)
+    {
+      printf("Error while writing %s.\n", output);
+      return -1;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+namespace headless
+{
+  /* entry point for "3deng --headless [frames] [output] [--format name]": renders the scene into memory
+     without initializing SDL video, so that it runs on machines without a display. The last frame is
+     written to output.ppm or output.png, every frame to output.y4m. Pixels are in the given format,
+     ARGB8888 by default. Returns the process exit code */
+  int run(int argc, char* argv[]);
+}
@@ -0,0 +1,116 @@
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile() : _data(nullptr), _size(0), _file(INVALID_HANDLE_VALUE), _mapping(nullptr) { }
+
+bool MappedFile::open(const path& path)
+{
+  close();
+
+  _file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (_file == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(_file, &size) || size.QuadPart == 0)
+  {
+    close();
+    return false;
+  }
+
+  _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!_mapping)
+  {
+    close();
+    return false;
+  }
+
+  _data = static_cast<const u8*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+  _size = size_t(size.QuadPart);
+
+  if (!_data)
+  {
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+void MappedFile::close()
+{
+  if (_data)
+    UnmapViewOfFile(_data);
+  if (_mapping)
+    CloseHandle(_mapping);
+  if (_file != INVALID_HANDLE_VALUE)
+    CloseHandle(_file);
+
+  _data = nullptr;
+  _size = 0;
+  _mapping = nullptr;
+  _file = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+MappedFile::MappedFile() : _data(nullptr), _size(0), _file(-1) { }
+
+bool MappedFile::open(const path& path)
+{
+  close();
+
+  _file = ::open(path.c_str(), O_RDONLY);
+  if (_file < 0)
+    return false;
+
+  struct stat info;
+  if (fstat(_file, &info) != 0 || info.st_size == 0)
+  {
+    close();
+    return false;
+  }
+
+  void* data = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, _file, 0);
+  if (data == MAP_FAILED)
+  {
+    close();
+    return false;
+  }
+
+  _data = static_cast<const u8*>(data);
+  _size = size_t(info.st_size);
+
+  return true;
+}
+
+void MappedFile::close()
+{
+  if (_data)
+    munmap(const_cast<u8*>(_data), _size);
+  if (_file >= 0)
+    ::close(_file);
+
+  _data = nullptr;
+  _size = 0;
+  _file = -1;
+}
+
+#endif
+
+MappedFile::~MappedFile()
+{
+  close();
+}
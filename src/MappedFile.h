@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Common.h"
+
+/* read only memory mapping of a whole file, pages are loaded lazily by the OS on first access */
+class MappedFile
+{
+private:
+  const u8* _data;
+  size_t _size;
+
+#if defined(_WIN32)
+  void* _file;
+  void* _mapping;
+#else
+  int _file;
+#endif
+
+public:
+  MappedFile();
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  /* returns false if the file can't be opened or mapped, empty files can't be mapped either */
+  bool open(const path& path);
+  void close();
+
+  bool isOpen() const { return _data != nullptr; }
+
+  const u8* data() const { return _data; }
+  size_t size() const { return _size; }
+};
@@ -0,0 +1,62 @@
+#include "Profiler.h"
+
+#include <algorithm>
+
+bool Profiler::_enabled = false;
+Profiler::Probe* Profiler::_probe = nullptr;
+
+std::array<double, Profiler::STAGE_COUNT> Profiler::_current;
+std::array<std::array<double, Profiler::WINDOW>, Profiler::STAGE_COUNT> Profiler::_history;
+size_t Profiler::_frame = 0;
+
+void Profiler::setEnabled(bool enabled)
+{
+  _enabled = enabled;
+
+  _current.fill(0.0);
+  for (auto& history : _history)
+    history.fill(0.0);
+  _frame = 0;
+}
+
+void Profiler::endFrame()
+{
+  if (!_enabled)
+    return;
+
+  const size_t slot = _frame % WINDOW;
+
+  for (size_t i = 0; i < STAGE_COUNT; ++i)
+  {
+    _history[i][slot] = _current[i];
+    _current[i] = 0.0;
+  }
+
+  ++_frame;
+}
+
+double Profiler::average(Stage stage)
+{
+  const size_t frames = std::min(_frame, WINDOW);
+  const auto& history = _history[size_t(stage)];
+
+  double sum = 0.0;
+  for (size_t i = 0; i < frames; ++i)
+    sum += history[i];
+
+  return frames ? sum / frames : 0.0;
+}
+
+const char* Profiler::name(Stage stage)
+{
+  switch (stage)
+  {
+    case Stage::OCCLUSION: return "occlusion";
+    case Stage::VERTEX: return "vertex";
+    case Stage::SETUP: return "setup";
+    case Stage::RASTERIZE: return "raster";
+    case Stage::UPLOAD: return "upload";
+    case Stage::PRESENT: return "present";
+    default: return "";
+  }
+}
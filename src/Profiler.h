@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Common.h"
+
+#include <array>
+#include <chrono>
+
+/* time spent in each stage of a frame, averaged over the last frames. Stages are timed by scopes
+   placed around coarse pieces of work (a whole object, a whole flush) on the thread that drives the
+   frame, so work the pool does on behalf of a stage is accounted to it.
+
+   When disabled a scope only tests a flag, which is nothing next to the work it wraps */
+class Profiler
+{
+public:
+  enum class Stage
+  {
+    OCCLUSION,
+    VERTEX,
+    SETUP,
+    RASTERIZE,
+    UPLOAD,
+    PRESENT,
+
+    COUNT
+  };
+
+  static constexpr size_t STAGE_COUNT = size_t(Stage::COUNT);
+  static constexpr size_t WINDOW = 60;
+
+  using clock_t = std::chrono::steady_clock;
+
+  /* measures something else than time at the same points, eg. hardware counters. Stages don't nest
+     so every begin is followed by the end of the same stage */
+  class Probe
+  {
+  public:
+    virtual ~Probe() { }
+    virtual void begin(Stage stage) = 0;
+    virtual void end(Stage stage) = 0;
+  };
+
+private:
+  static bool _enabled;
+  static Probe* _probe;
+
+  static std::array<double, STAGE_COUNT> _current;
+  static std::array<std::array<double, WINDOW>, STAGE_COUNT> _history;
+  static size_t _frame;
+
+public:
+  static bool isEnabled() { return _enabled; }
+  /* history is dropped on both transitions so that averages never mix profiled and unprofiled frames */
+  static void setEnabled(bool enabled);
+
+  /* the probe is called by scopes while the profiler is enabled */
+  static void setProbe(Probe* probe) { _probe = probe; }
+  static Probe* probe() { return _probe; }
+
+  static void add(Stage stage, clock_t::duration elapsed) { _current[size_t(stage)] += std::chrono::duration<double>(elapsed).count(); }
+
+  /* closes the current frame and moves it into the rolling window */
+  static void endFrame();
+
+  /* average time per frame spent in stage over the window, in seconds */
+  static double average(Stage stage);
+  static const char* name(Stage stage);
+};
+
+/* accounts the time until the end of the enclosing scope to a stage */
+class ProfileScope
+{
+private:
+  Profiler::Stage _stage;
+  bool _enabled;
+  Profiler::clock_t::time_point _start;
+
+public:
+  ProfileScope(Profiler::Stage stage) : _stage(stage), _enabled(Profiler::isEnabled())
+  {
+    if (_enabled)
+    {
+      if (Profiler::probe())
+        Profiler::probe()->begin(stage);
+      _start = Profiler::clock_t::now();
+    }
+  }
+
+  ~ProfileScope() { stop(); }
+
+  /* ends the scope early, when stages follow each other in the same function */
+  void stop()
+  {
+    if (_enabled)
+    {
+      Profiler::add(_stage, Profiler::clock_t::now() - _start);
+      if (Profiler::probe())
+        Profiler::probe()->end(_stage);
+    }
+    _enabled = false;
+  }
+};
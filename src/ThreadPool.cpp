@@ -0,0 +1,148 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t count) : _generation(0), _quit(false), _context(nullptr), _trampoline(nullptr), _remaining(0)
+{
+  if (count == 0)
+    count = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+  _queues = std::vector<queue_t>(count);
+  for (auto& queue : _queues)
+    queue.head = 0;
+
+  for (size_t i = 1; i < count; ++i)
+    _threads.emplace_back(&ThreadPool::worker, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(_lock);
+    _quit = true;
+  }
+
+  _wake.notify_all();
+
+  for (auto& thread : _threads)
+    thread.join();
+}
+
+void ThreadPool::worker(size_t index)
+{
+  u64 seen = 0;
+
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(_lock);
+      _wake.wait(lock, [this, seen]() { return _quit || _generation != seen; });
+
+      if (_quit)
+        return;
+
+      seen = _generation;
+    }
+
+    runTasks(index);
+  }
+}
+
+bool ThreadPool::pop(size_t worker, u32& task)
+{
+  auto& queue = _queues[worker];
+  std::lock_guard<std::mutex> lock(queue.lock);
+
+  if (queue.tasks.size() > queue.head)
+  {
+    task = queue.tasks.back();
+    queue.tasks.pop_back();
+    return true;
+  }
+
+  return false;
+}
+
+bool ThreadPool::steal(size_t worker, u32& task)
+{
+  for (size_t i = 1; i < _queues.size(); ++i)
+  {
+    auto& queue = _queues[(worker + i) % _queues.size()];
+    std::lock_guard<std::mutex> lock(queue.lock);
+
+    if (queue.tasks.size() > queue.head)
+    {
+      task = queue.tasks[queue.head++];
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void ThreadPool::runTasks(size_t worker)
+{
+  u32 task;
+
+  while (pop(worker, task) || steal(worker, task))
+  {
+    /* context and trampoline are published before the queues are filled, the queue lock orders them */
+    _trampoline(_context, task, worker);
+
+    if (_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+      std::lock_guard<std::mutex> lock(_lock);
+      _done.notify_all();
+    }
+  }
+}
+
+void ThreadPool::run(size_t count, void* context, trampoline_t trampoline)
+{
+  if (count == 0)
+    return;
+
+  /* nothing to share, skip the synchronization entirely */
+  if (_queues.size() == 1 || count == 1)
+  {
+    for (size_t i = 0; i < count; ++i)
+      trampoline(context, i, 0);
+    return;
+  }
+
+  _context = context;
+  _trampoline = trampoline;
+  _remaining.store(count, std::memory_order_relaxed);
+
+  /* lower indices end up at the back of the queues so they're picked first by their owners */
+  for (size_t w = 0; w < _queues.size(); ++w)
+  {
+    auto& queue = _queues[w];
+    std::lock_guard<std::mutex> lock(queue.lock);
+
+    queue.tasks.clear();
+    queue.head = 0;
+
+    if (w < count)
+    {
+      for (size_t i = w + ((count - 1 - w) / _queues.size()) * _queues.size(); ; i -= _queues.size())
+      {
+        queue.tasks.push_back(u32(i));
+        if (i < _queues.size())
+          break;
+      }
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(_lock);
+    ++_generation;
+  }
+
+  _wake.notify_all();
+
+  runTasks(0);
+
+  std::unique_lock<std::mutex> lock(_lock);
+  _done.wait(lock, [this]() { return _remaining.load(std::memory_order_acquire) == 0; });
+}
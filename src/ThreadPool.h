@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Common.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* fixed size pool of workers which executes indexed tasks. Every worker owns a queue which is
+   filled round robin when a job is submitted, a worker pops from the back of its own queue and
+   when it runs dry steals from the front of the others. The thread which submits the job takes
+   part in the work as worker 0 and the call returns only when every task has been executed.
+
+   No allocation happens while running jobs once queues have grown to the largest job size. */
+class ThreadPool
+{
+private:
+  struct alignas(64) queue_t
+  {
+    std::mutex lock;
+    std::vector<u32> tasks;
+    size_t head;
+  };
+
+  using trampoline_t = void(*)(void*, size_t, size_t);
+
+  std::vector<std::thread> _threads;
+  std::vector<queue_t> _queues;
+
+  std::mutex _lock;
+  std::condition_variable _wake;
+  std::condition_variable _done;
+  u64 _generation;
+  bool _quit;
+
+  void* _context;
+  trampoline_t _trampoline;
+  std::atomic<size_t> _remaining;
+
+  void worker(size_t index);
+  void runTasks(size_t worker);
+  bool pop(size_t worker, u32& task);
+  bool steal(size_t worker, u32& task);
+
+  void run(size_t count, void* context, trampoline_t trampoline);
+
+public:
+  /* count is the total amount of workers including the calling thread, 0 means one per core */
+  ThreadPool(size_t count = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  size_t size() const { return _queues.size(); }
+
+  /* invokes function(index, worker) for every index in [0, count) and waits for completion */
+  template<typename F>
+  void parallelFor(size_t count, F&& function)
+  {
+    using function_t = typename std::remove_reference<F>::type;
+    run(count, &function, [](void* context, size_t index, size_t worker) {
+      (*static_cast<function_t*>(context))(index, worker);
+    });
+  }
+};
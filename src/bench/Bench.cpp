@@ -0,0 +1,61 @@
+#include "Bench.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace bench
+{
+  struct entry_t
+  {
+    const char* name;
+    void(*function)();
+    const char* description;
+  };
+
+  static const entry_t benchmarks[] = {
+    { "raster", &raster, "triangle traversal throughput, full screen scan versus bounding box" },
+    { "hiz", &hiz, "per pixel depth testing against coarse rejection on 8x8 depth blocks" },
+    { "visibility", &visibility, "forward shading against a visibility buffer as overdraw grows, back to front and front to back" },
+    { "threads", &threads, "tile binned rasterization scaling from 1 to one thread per core" },
+    { "coverage", &coverage, "coverage kernels (scalar, SSE2, AVX2) alone and inside the rasterizer" },
+    { "vertices", &vertices, "indexed vertex processing versus transforming every triangle on its own" },
+    { "culling", &culling, "frustum and back face culling on a field of cubes around the camera" },
+    { "occlusion", &occlusion, "whole objects culled against occluders in a low resolution depth buffer, in a city grid" },
+    { "meshfile", &meshfile, "loading meshes by welding a soup, reading a file or mapping a mesh file" },
+    { "obj", &obj, "parsing Wavefront OBJ text into indexed meshes on one or more threads" },
+    { "texlayout", &texlayout, "texture sampling throughput at rotation angles for linear, tiled and Morton texel layouts" },
+    { "mipmap", &mipmap, "mip chain generation and sampling minified surfaces without mipmaps, nearest mip and trilinear" },
+    { "bilinear", &bilinear, "bilinear filtering kernels (scalar, SSE2, AVX2 with loads or gathers) against nearest sampling" },
+    { "texload", &texload, "loading a large atlas by row copies versus converting each pixel with SDL_GetRGBA" },
+  };
+
+  int run(int argc, char* argv[])
+  {
+    bool any = false;
+
+    for (const auto& benchmark : benchmarks)
+    {
+      bool selected = argc == 0;
+
+      for (int i = 0; i < argc; ++i)
+        selected |= strcmp(argv[i], benchmark.name) == 0;
+
+      if (selected)
+      {
+        printf("[%s] %s\n", benchmark.name, benchmark.description);
+        benchmark.function();
+        any = true;
+      }
+    }
+
+    if (!any)
+    {
+      printf("Unknown benchmark, available ones:\n");
+      for (const auto& benchmark : benchmarks)
+        printf("  %-12s %s\n", benchmark.name, benchmark.description);
+      return -1;
+    }
+
+    return 0;
+  }
+}
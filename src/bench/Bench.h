@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Common.h"
+
+#include <chrono>
+#include <functional>
+
+namespace bench
+{
+  class Timer
+  {
+  private:
+    using clock_t = std::chrono::high_resolution_clock;
+    clock_t::time_point _start;
+
+  public:
+    Timer() : _start(clock_t::now()) { }
+
+    void restart() { _start = clock_t::now(); }
+    double seconds() const { return std::chrono::duration<double>(clock_t::now() - _start).count(); }
+  };
+
+  struct measure_t
+  {
+    size_t iterations;
+    double seconds;
+
+    double perSecond(double amount) const { return amount / seconds; }
+  };
+
+  /* runs the function repeatedly until at least minSeconds have elapsed */
+  inline measure_t measure(const std::function<void()>& function, double minSeconds = 0.5)
+  {
+    Timer timer;
+    measure_t result = { 0, 0.0 };
+
+    do
+    {
+      function();
+      ++result.iterations;
+      result.seconds = timer.seconds();
+    } while (result.seconds < minSeconds);
+
+    return result;
+  }
+
+  /* entry point for "3deng --bench [name...]", returns the process exit code */
+  int run(int argc, char* argv[]);
+
+  /* entry point for "3deng --suite [options] [scene...]": renders fixed scenes along a scripted camera
+     path for a fixed number of frames and reports frame time percentiles and throughput as JSON, runs
+     with the same options are meant to be compared against each other. With --counters hardware
+     counters are collected for each frame and each profiler stage, where the platform allows it. With
+     --format the scenes are drawn in another pixel format, checksums stay comparable across formats */
+  int suite(int argc, char* argv[]);
+
+  void raster();
+  void visibility();
+  void hiz();
+  void threads();
+  void coverage();
+  void vertices();
+  void culling();
+  void occlusion();
+  void meshfile();
+  void obj();
+  void texlayout();
+  void mipmap();
+  void bilinear();
+  void texload();
+}
@@ -0,0 +1,192 @@
+#include "Bench.h"
+
+#include "gfx/Mesh.h"
+#include "gfx/MeshFile.h"
+#include "gfx/ObjImporter.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace a3d;
+
+namespace
+{
+  /* flat grid as a triangle soup, like the ones meshes are welded from */
+  std::vector<float> gridSoup(u32 cells)
+  {
+    std::vector<float> soup;
+    soup.reserve(size_t(cells) * cells * 18);
+
+    auto push = [&soup, cells](u32 x, u32 y) {
+      soup.insert(soup.end(), { float(x) / cells, float(y) / cells, 0.0f });
+    };
+
+    for (u32 y = 0; y < cells; ++y)
+      for (u32 x = 0; x < cells; ++x)
+      {
+        push(x, y); push(x + 1, y); push(x, y + 1);
+        push(x + 1, y); push(x + 1, y + 1); push(x, y + 1);
+      }
+
+    return soup;
+  }
+
+  /* OBJ text of a grid with positions, uvs and normals, as written by most exporters */
+  std::string gridObj(u32 cells)
+  {
+    std::string text;
+    char line[128];
+
+    for (u32 y = 0; y <= cells; ++y)
+      for (u32 x = 0; x <= cells; ++x)
+      {
+        snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvt %.6f %.6f\n", float(x) / cells, float(y) / cells, 0.0f, float(x) / cells, float(y) / cells);
+        text += line;
+      }
+
+    text += "vn 0.000000 0.000000 1.000000\n";
+
+    auto corner = [cells](u32 x, u32 y) { return y * (cells + 1) + x + 1; };
+
+    for (u32 y = 0; y < cells; ++y)
+      for (u32 x = 0; x < cells; ++x)
+      {
+        const u32 a = corner(x, y), b = corner(x + 1, y), c = corner(x + 1, y + 1), d = corner(x, y + 1);
+        snprintf(line, sizeof(line), "f %u/%u/1 %u/%u/1 %u/%u/1 %u/%u/1\n", a, a, b, b, c, c, d, d);
+        text += line;
+      }
+
+    return text;
+  }
+
+  /* touches a value per page, as the first draw of a mapped mesh would */
+  float touch(const u8* data, size_t size)
+  {
+    float sum = 0.0f;
+
+    for (size_t offset = 0; offset + sizeof(float) <= size; offset += 4096)
+      sum += *reinterpret_cast<const float*>(data + offset);
+
+    return sum;
+  }
+}
+
+void bench::meshfile()
+{
+  const char* fileName = "bench.a3dm";
+
+  printf("  %-8s %10s %12s %12s %12s %12s\n", "cells", "vertices", "bytes", "weld ms", "read ms", "map ms");
+
+  for (u32 cells : { 64u, 256u, 768u })
+  {
+    const auto soup = gridSoup(cells);
+
+    Timer timer;
+    Mesh mesh = MeshBuilder::fromSoup(soup.data(), soup.size());
+    const double weld = timer.seconds();
+
+    if (!MeshFile::write(mesh, fileName))
+    {
+      printf("  unable to write %s\n", fileName);
+      return;
+    }
+
+    /* results are accumulated so that touching the data can't be optimized away */
+    volatile float sink = 0.0f;
+
+    /* plain read of the whole file into memory, what a parser would start from */
+    auto read = bench::measure([&]() {
+      FILE* file = fopen(fileName, "rb");
+      if (!file)
+        return;
+
+      fseek(file, 0, SEEK_END);
+      std::vector<u8> data(size_t(ftell(file)));
+      fseek(file, 0, SEEK_SET);
+      fread(data.data(), 1, data.size(), file);
+      fclose(file);
+      sink = sink + touch(data.data(), data.size());
+    }, 0.2);
+
+    /* mapping and validating the file then touching every page of the streams */
+    auto mapped = bench::measure([&]() {
+      MappedMesh mapped;
+      if (!mapped.open(fileName))
+        return;
+
+      const size_t indexSize = mapped.triangleCount() * 3 * (mapped.indexType() == IndexType::U16 ? sizeof(u16) : sizeof(u32));
+      sink = sink + touch(reinterpret_cast<const u8*>(mapped.positions()), mapped.vertexCount() * sizeof(vec3)) +
+        touch(reinterpret_cast<const u8*>(mapped.normals()), mapped.vertexCount() * sizeof(vec3)) +
+        touch(reinterpret_cast<const u8*>(mapped.textureCoords()), mapped.vertexCount() * sizeof(vec2)) +
+        touch(static_cast<const u8*>(mapped.indices()), indexSize);
+    }, 0.2);
+
+    printf("  %-8u %10zu %12zu %12.3f %12.3f %12.3f\n", cells, mesh.vertexCount(), mesh.sizeInBytes(), weld * 1e3,
+      read.seconds / read.iterations * 1e3, mapped.seconds / mapped.iterations * 1e3);
+  }
+
+  remove(fileName);
+}
+
+void bench::obj()
+{
+  const char* fileName = "bench.obj";
+  const size_t maxThreads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+  for (u32 cells : { 128u, 768u })
+  {
+    const std::string text = gridObj(cells);
+    const double megabytes = text.size() / double(1 << 20);
+
+    printf("  grid %u, %.1f MB\n", cells, megabytes);
+    printf("    %-8s %10s %12s %12s %12s %10s\n", "threads", "vertices", "triangles", "MB/s", "Mtris/s", "speedup");
+
+    double baseline = 0.0;
+
+    for (size_t count = 1; count <= maxThreads; count *= 2)
+    {
+      ThreadPool pool(count);
+      ObjImporter importer(count > 1 ? &pool : nullptr);
+      Mesh mesh;
+
+      auto result = bench::measure([&]() {
+        if (!importer.parse(text.data(), text.size(), mesh))
+          printf("    %s\n", importer.error().c_str());
+      }, 0.2);
+
+      const double seconds = result.seconds / result.iterations;
+
+      if (count == 1)
+        baseline = seconds;
+
+      printf("    %-8zu %10zu %12zu %12.1f %12.2f %9.2fx\n", count, mesh.vertexCount(), mesh.triangleCount(),
+        megabytes / seconds, mesh.triangleCount() / seconds / 1e6, baseline / seconds);
+    }
+
+    /* same text from a mapped file, with every thread */
+    FILE* file = fopen(fileName, "wb");
+    if (!file || fwrite(text.data(), 1, text.size(), file) != text.size())
+    {
+      printf("    unable to write %s\n", fileName);
+      if (file)
+        fclose(file);
+      return;
+    }
+    fclose(file);
+
+    ThreadPool pool(maxThreads);
+    ObjImporter importer(&pool);
+    Mesh mesh;
+
+    auto loaded = bench::measure([&]() { importer.load(fileName, mesh); }, 0.2);
+    const double seconds = loaded.seconds / loaded.iterations;
+
+    printf("    %-8s %10zu %12zu %12.1f %12.2f\n", "file", mesh.vertexCount(), mesh.triangleCount(), megabytes / seconds, mesh.triangleCount() / seconds / 1e6);
+  }
+
+  remove(fileName);
+}
@@ -0,0 +1,145 @@
+#include "PerfCounters.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+using namespace bench;
+
+PerfCounters::PerfCounters() : _leader(-1), _count(0)
+{
+  _files.fill(-1);
+  _slots.fill(-1);
+}
+
+PerfCounters::~PerfCounters()
+{
+  close();
+}
+
+const char* PerfCounters::name(Event event)
+{
+  switch (event)
+  {
+    case Event::CYCLES: return "cycles";
+    case Event::INSTRUCTIONS: return "instructions";
+    case Event::BRANCH_MISSES: return "branch_misses";
+    case Event::LLC_MISSES: return "llc_misses";
+    default: return "";
+  }
+}
+
+#if defined(__linux__)
+
+bool PerfCounters::open()
+{
+  close();
+
+  const u64 configs[EVENT_COUNT] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_BRANCH_MISSES,
+    PERF_COUNT_HW_CACHE_MISSES,
+  };
+
+  int firstError = 0;
+
+  for (size_t i = 0; i < EVENT_COUNT; ++i)
+  {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = configs[i];
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    /* the group is enabled at once through its leader */
+    attr.disabled = _leader < 0 ? 1 : 0;
+
+    const int file = int(syscall(SYS_perf_event_open, &attr, 0, -1, _leader, 0));
+
+    if (file < 0)
+    {
+      if (!firstError)
+        firstError = errno;
+      continue;
+    }
+
+    if (_leader < 0)
+      _leader = file;
+
+    _files[i] = file;
+    _slots[i] = int(_count++);
+  }
+
+  if (_leader < 0)
+  {
+    _error = std::string("perf_event_open failed: ") + strerror(firstError);
+    if (firstError == EACCES || firstError == EPERM)
+      _error += ", see /proc/sys/kernel/perf_event_paranoid";
+    return false;
+  }
+
+  ioctl(_leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+
+  return true;
+}
+
+void PerfCounters::close()
+{
+  for (int& file : _files)
+  {
+    if (file >= 0)
+      ::close(file);
+    file = -1;
+  }
+
+  _slots.fill(-1);
+  _leader = -1;
+  _count = 0;
+}
+
+PerfCounters::values_t PerfCounters::read() const
+{
+  values_t values;
+  values.fill(0);
+
+  /* the group is read as the number of events followed by their values in the order they were added */
+  u64 buffer[1 + EVENT_COUNT];
+
+  if (_leader < 0 || ::read(_leader, buffer, sizeof(u64) * (1 + _count)) != ssize_t(sizeof(u64) * (1 + _count)))
+    return values;
+
+  for (size_t i = 0; i < EVENT_COUNT; ++i)
+    if (_slots[i] >= 0)
+      values[i] = buffer[1 + _slots[i]];
+
+  return values;
+}
+
+#else
+
+bool PerfCounters::open()
+{
+  _error = "hardware counters are read through perf_event_open which is only available on Linux";
+  return false;
+}
+
+void PerfCounters::close() { }
+
+PerfCounters::values_t PerfCounters::read() const
+{
+  values_t values;
+  values.fill(0);
+  return values;
+}
+
+#endif
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Common.h"
+
+#include <array>
+#include <string>
+
+namespace bench
+{
+  /* hardware counters of the calling thread read through perf_event_open. Events are opened as a
+     single group so that they're scheduled together and read with one system call, events the CPU or
+     the kernel don't support are left out of the group and read as zero.
+
+     Only user space is counted, and only the thread which opened the counters: work done by pool
+     workers isn't included. Opening fails everywhere but on Linux and when perf_event_paranoid
+     forbids it, error() tells why */
+  class PerfCounters
+  {
+  public:
+    enum class Event
+    {
+      CYCLES,
+      INSTRUCTIONS,
+      BRANCH_MISSES,
+      LLC_MISSES,
+
+      COUNT
+    };
+
+    static constexpr size_t EVENT_COUNT = size_t(Event::COUNT);
+
+    using values_t = std::array<u64, EVENT_COUNT>;
+
+  private:
+    std::array<int, EVENT_COUNT> _files;
+    /* position of each event in the values read from the group, or -1 if it's not in the group */
+    std::array<int, EVENT_COUNT> _slots;
+    int _leader;
+    size_t _count;
+    std::string _error;
+
+  public:
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    /* returns false if no event can be counted, counting starts right away */
+    bool open();
+    void close();
+
+    bool isOpen() const { return _leader >= 0; }
+    bool isAvailable(Event event) const { return _slots[size_t(event)] >= 0; }
+    const std::string& error() const { return _error; }
+
+    /* running totals since open(), differences between two reads give the counts in between */
+    values_t read() const;
+
+    static const char* name(Event event);
+  };
+}
@@ -0,0 +1,478 @@
+#include "Bench.h"
+
+#include "gfx/Rasterizer.h"
+#include "ThreadPool.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace a3d;
+
+namespace
+{
+  constexpr coord_t BENCH_WIDTH = 320;
+  constexpr coord_t BENCH_HEIGHT = 240;
+
+  struct bench_triangle_t
+  {
+    rasterize::Triangle triangle;
+    std::array<vec2, 3> textureCoords;
+  };
+
+  std::vector<bench_triangle_t> generate(size_t count, float radius, u32 seed)
+  {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    std::vector<bench_triangle_t> triangles(count);
+
+    for (auto& t : triangles)
+    {
+      vec2 center = vec2(unit(rng) * BENCH_WIDTH, unit(rng) * BENCH_HEIGHT);
+
+      for (size_t i = 0; i < 3; ++i)
+      {
+        float angle = (i + unit(rng) * 0.5f) * 2.0944f;
+        const float w = 2.0f + unit(rng) * 8.0f;
+        t.triangle.vertices[i] = vec4(center.x + std::cos(angle) * radius, center.y + std::sin(angle) * radius, 1.0f - 0.2f / w, w);
+        t.textureCoords[i] = vec2(unit(rng), unit(rng));
+      }
+
+      t.triangle.setVarying(0, t.textureCoords);
+    }
+
+    return triangles;
+  }
+
+  /* count screen filling layers, each made of two triangles with its own depth and texture offset */
+  std::vector<rasterize::Triangle> overdrawLayers(size_t count, bool frontToBack)
+  {
+    std::vector<rasterize::Triangle> triangles;
+
+    for (size_t l = 0; l < count; ++l)
+    {
+      const size_t layer = frontToBack ? l : count - 1 - l;
+      const float z = 0.1f + 0.8f * layer / count, offset = 0.37f * layer;
+      const vec4 corners[] = { vec4(0, 0, z, 1), vec4(BENCH_WIDTH, 0, z, 1), vec4(0, BENCH_HEIGHT, z, 1), vec4(BENCH_WIDTH, BENCH_HEIGHT, z, 1) };
+      const vec2 uvs[] = { vec2(offset, offset), vec2(offset + 1.5f, offset), vec2(offset, offset + 1.125f), vec2(offset + 1.5f, offset + 1.125f) };
+
+      for (const auto& indices : { std::array<int, 3>{ 0, 1, 2 }, std::array<int, 3>{ 1, 3, 2 } })
+      {
+        rasterize::Triangle triangle;
+        std::array<vec2, 3> coords;
+
+        for (size_t i = 0; i < 3; ++i)
+        {
+          triangle.vertices[i] = corners[indices[i]];
+          coords[i] = uvs[indices[i]];
+        }
+
+        triangle.setVarying(0, coords);
+        triangles.push_back(triangle);
+      }
+    }
+
+    return triangles;
+  }
+
+  /* the original per pixel interpolation: barycentric coordinates are recomputed from scratch and
+     every attribute is divided by w again for each fragment */
+  template<typename T>
+  T computeCorrectedVertexAttribute(const rasterize::Triangle& triangle, std::array<T, 3> attribute, const vec2& fragment)
+  {
+    auto bc = math::triangles::barycentricCoords(fragment, triangle[0].xy(), triangle[1].xy(), triangle[2].xy());
+
+    for (size_t i = 0; i < attribute.size(); ++i)
+      attribute[i] /= triangle[i].w;
+
+    float w = 1 / (bc.lambdas[0] * (1 / triangle[0].w) + bc.lambdas[1] * (1 / triangle[1].w) + bc.lambdas[2] * (1 / triangle[2].w));
+
+    return w * (attribute[0] * bc.lambdas[0] + attribute[1] * bc.lambdas[1] + attribute[2] * bc.lambdas[2]);
+  }
+
+  /* the original MainView loop: every pixel of the screen is tested against every triangle */
+  u64 drawFullScreen(const bench_triangle_t& t, const Texture& texture, RenderTarget& target)
+  {
+    u64 fragments = 0;
+    const auto& triangle = t.triangle;
+    std::array<float, 3> zeds = { triangle[0].z, triangle[1].z, triangle[2].z };
+
+    for (size_t x = 0; x < BENCH_WIDTH; ++x)
+      for (size_t y = 0; y < BENCH_HEIGHT; ++y)
+      {
+        if (math::intersections::is2dPointInsideTriangle(vec2(x, y), triangle[0].xy(), triangle[1].xy(), triangle[2].xy()))
+        {
+          ++fragments;
+          float z = computeCorrectedVertexAttribute(triangle, zeds, vec2(x, y));
+
+          if (z < target.depth().get(x, y))
+          {
+            vec2 tx = computeCorrectedVertexAttribute(triangle, t.textureCoords, vec2(x, y));
+            target.colorRow(y)[x] = texture.sample(tx);
+            target.depth().get(x, y) = z;
+          }
+        }
+      }
+
+    return fragments;
+  }
+
+  u64 checksum(const RenderTarget& target)
+  {
+    u64 hash = 14695981039346656037ull;
+
+    for (coord_t y = 0; y < target.height(); ++y)
+      for (coord_t x = 0; x < target.width(); ++x)
+        hash = (hash ^ target.colorRow(y)[x]) * 1099511628211ull;
+
+    return hash;
+  }
+}
+
+void bench::raster()
+{
+  struct scenario_t { const char* name; size_t count; float radius; };
+  const scenario_t scenarios[] = {
+    { "small", 2000, 4.0f },
+    { "medium", 200, 32.0f },
+    { "large", 20, 160.0f },
+  };
+
+  Texture texture(128, 128);
+  Buffer2D<u32> colorBuffer(BENCH_WIDTH, BENCH_HEIGHT);
+  RenderTarget target(BENCH_WIDTH, BENCH_HEIGHT);
+  target.bindColor(colorBuffer.data(), colorBuffer.width());
+
+  rasterize::Rasterizer rasterizer;
+  rasterizer.setTarget(&target);
+  rasterizer.setTexture(&texture);
+
+  auto clear = [&target]() { target.clear(0, std::numeric_limits<float>::max()); };
+
+  printf("  %-8s %10s %14s %14s %10s\n", "scene", "path", "Mtris/s", "Mfrags/s", "speedup");
+
+  for (const auto& scenario : scenarios)
+  {
+    auto triangles = generate(scenario.count, scenario.radius, 1337);
+
+    u64 fullScreenFragments = 0;
+    auto fullScreen = bench::measure([&]() {
+      clear();
+      for (const auto& t : triangles)
+        fullScreenFragments += drawFullScreen(t, texture, target);
+    });
+
+    rasterizer.resetStats();
+    auto boundingBox = bench::measure([&]() {
+      clear();
+      for (const auto& t : triangles)
+        rasterizer.draw(t.triangle);
+      rasterizer.flush();
+    });
+
+    const double fullScreenFps = fullScreen.perSecond(double(fullScreen.iterations));
+    const double boundingBoxFps = boundingBox.perSecond(double(boundingBox.iterations));
+
+    printf("  %-8s %10s %14.3f %14.3f %10s\n", scenario.name, "full",
+      fullScreen.perSecond(double(fullScreen.iterations * triangles.size())) / 1e6,
+      fullScreen.perSecond(double(fullScreenFragments)) / 1e6, "");
+    printf("  %-8s %10s %14.3f %14.3f %9.1fx\n", scenario.name, "bbox",
+      boundingBox.perSecond(double(boundingBox.iterations * triangles.size())) / 1e6,
+      boundingBox.perSecond(double(rasterizer.stats().fragments)) / 1e6,
+      boundingBoxFps / fullScreenFps);
+  }
+}
+
+void bench::threads()
+{
+  Texture texture(128, 128);
+  Buffer2D<u32> colorBuffer(BENCH_WIDTH, BENCH_HEIGHT);
+  RenderTarget target(BENCH_WIDTH, BENCH_HEIGHT);
+  target.bindColor(colorBuffer.data(), colorBuffer.width());
+
+  rasterize::Rasterizer rasterizer;
+  rasterizer.setTarget(&target);
+  rasterizer.setTexture(&texture);
+
+  auto triangles = generate(4000, 24.0f, 1337);
+  auto large = generate(50, 160.0f, 7331);
+  triangles.insert(triangles.end(), large.begin(), large.end());
+
+  const size_t maxThreads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+  printf("  %-8s %14s %14s %10s %18s\n", "threads", "frames/s", "Mfrags/s", "speedup", "checksum");
+
+  double baseline = 0.0;
+  u64 reference = 0;
+
+  for (size_t count = 1; count <= maxThreads; ++count)
+  {
+    ThreadPool pool(count);
+    rasterizer.setThreadPool(&pool);
+    rasterizer.resetStats();
+
+    auto result = bench::measure([&]() {
+      target.clear(0, std::numeric_limits<float>::max());
+      for (const auto& t : triangles)
+        rasterizer.draw(t.triangle);
+      rasterizer.flush();
+    });
+
+    const double fps = result.perSecond(double(result.iterations));
+    const u64 hash = checksum(target);
+
+    if (count == 1)
+    {
+      baseline = fps;
+      reference = hash;
+    }
+
+    printf("  %-8zu %14.1f %14.3f %9.2fx %18llx%s\n", count, fps, result.perSecond(double(rasterizer.stats().fragments)) / 1e6,
+      fps / baseline, (unsigned long long)hash, hash == reference ? "" : " MISMATCH");
+  }
+
+  rasterizer.setThreadPool(nullptr);
+}
+
+void bench::coverage()
+{
+  using namespace a3d::rasterize;
+
+  struct scenario_t { const char* name; size_t count; float radius; };
+  const scenario_t scenarios[] = {
+    { "small", 2000, 4.0f },
+    { "medium", 200, 32.0f },
+    { "large", 20, 160.0f },
+  };
+
+  const CoverageKernel kernels[] = { CoverageKernel::SCALAR, CoverageKernel::SSE2, CoverageKernel::AVX2 };
+
+  Texture texture(128, 128);
+  Buffer2D<u32> colorBuffer(BENCH_WIDTH, BENCH_HEIGHT);
+  RenderTarget target(BENCH_WIDTH, BENCH_HEIGHT);
+  target.bindColor(colorBuffer.data(), colorBuffer.width());
+
+  rasterize::Rasterizer rasterizer;
+  rasterizer.setTarget(&target);
+  rasterizer.setTexture(&texture);
+
+  printf("  %-8s %8s %14s %14s %10s %18s\n", "scene", "kernel", "Mpixels/s", "Mfrags/s", "speedup", "checksum");
+
+  for (const auto& scenario : scenarios)
+  {
+    auto triangles = generate(scenario.count, scenario.radius, 1337);
+
+    /* the blocks the rasterizer would hand to the kernel, triangle bounding boxes split on tile boundaries */
+    struct block_t { size_t setup; coord_t x, y, width, height; };
+    std::vector<TriangleSetup> setups;
+    std::vector<block_t> blocks;
+    u64 pixels = 0;
+
+    for (const auto& t : triangles)
+    {
+      TriangleSetup setup;
+      if (!rasterizer.setup(t.triangle, setup))
+        continue;
+
+      for (coord_t y = setup.minY & ~(Rasterizer::TILE_SIZE - 1); y <= setup.maxY; y += Rasterizer::TILE_SIZE)
+        for (coord_t x = setup.minX & ~(Rasterizer::TILE_SIZE - 1); x <= setup.maxX; x += Rasterizer::TILE_SIZE)
+        {
+          block_t block;
+          block.setup = setups.size();
+          block.x = std::max(x, setup.minX);
+          block.y = std::max(y, setup.minY);
+          block.width = std::min(x + Rasterizer::TILE_SIZE - 1, setup.maxX) - block.x + 1;
+          block.height = std::min(y + Rasterizer::TILE_SIZE - 1, setup.maxY) - block.y + 1;
+
+          if (coverage::fitsVectorRange(setup.edges, block.x, block.y, block.height))
+          {
+            blocks.push_back(block);
+            pixels += block.width * block.height;
+          }
+        }
+
+      setups.push_back(setup);
+    }
+
+    double baseline = 0.0;
+
+    for (CoverageKernel kernel : kernels)
+    {
+      if (!coverage::isSupported(kernel))
+      {
+        printf("  %-8s %8s %14s\n", scenario.name, coverage::name(kernel), "unsupported");
+        continue;
+      }
+
+      auto function = coverage::function(kernel);
+      u32 masks[coverage::MAX_WIDTH];
+      u64 hash = 0;
+
+      auto kernelOnly = bench::measure([&]() {
+        hash = 14695981039346656037ull;
+        for (const auto& block : blocks)
+        {
+          function(setups[block.setup].edges, block.x, block.y, block.width, block.height, masks);
+          for (coord_t r = 0; r < block.height; ++r)
+            hash = (hash ^ masks[r]) * 1099511628211ull;
+        }
+      });
+
+      rasterizer.setCoverageKernel(kernel);
+      rasterizer.resetStats();
+      auto full = bench::measure([&]() {
+        target.clear(0, std::numeric_limits<float>::max());
+        for (const auto& t : triangles)
+          rasterizer.draw(t.triangle);
+        rasterizer.flush();
+      });
+
+      const double rate = kernelOnly.perSecond(double(pixels * kernelOnly.iterations));
+      if (kernel == CoverageKernel::SCALAR)
+        baseline = rate;
+
+      printf("  %-8s %8s %14.1f %14.3f %9.2fx %18llx\n", scenario.name, coverage::name(kernel), rate / 1e6,
+        full.perSecond(double(rasterizer.stats().fragments)) / 1e6, rate / baseline, (unsigned long long)hash);
+    }
+  }
+}
+
+void bench::visibility()
+{
+  using namespace a3d::rasterize;
+
+  ThreadPool pool(1);
+  Texture texture(256, 256);
+  texture.generateMipmaps(&pool);
+
+  Buffer2D<u32> colorBuffer(BENCH_WIDTH, BENCH_HEIGHT);
+  RenderTarget target(BENCH_WIDTH, BENCH_HEIGHT);
+  target.bindColor(colorBuffer.data(), colorBuffer.width());
+
+  Rasterizer rasterizer;
+  rasterizer.setTarget(&target);
+  rasterizer.setTexture(&texture);
+  rasterizer.setMipFilter(MipFilter::LINEAR);
+  rasterizer.setTextureFilter(TextureFilter::BILINEAR);
+
+  const double pixels = double(BENCH_WIDTH) * BENCH_HEIGHT;
+
+  printf("  %-8s %14s %12s %10s %10s %12s %10s %18s\n", "layers", "order", "mode", "overdraw", "shaded/px", "frames/s", "speedup", "checksum");
+
+  for (size_t count : { 1, 2, 4, 8 })
+  {
+    for (bool frontToBack : { false, true })
+    {
+      const auto triangles = overdrawLayers(count, frontToBack);
+      double baseline = 0.0;
+      u64 reference = 0;
+
+      for (ShadingMode mode : { ShadingMode::FORWARD, ShadingMode::VISIBILITY })
+      {
+        rasterizer.setShadingMode(mode);
+        rasterizer.resetStats();
+
+        auto result = bench::measure([&]() {
+          target.clear(0, std::numeric_limits<float>::max());
+          for (const auto& triangle : triangles)
+            rasterizer.draw(triangle);
+          rasterizer.flush();
+        }, 0.3);
+
+        const double fps = result.perSecond(double(result.iterations));
+        const u64 hash = checksum(target);
+        const auto& stats = rasterizer.stats();
+
+        if (mode == ShadingMode::FORWARD)
+        {
+          baseline = fps;
+          reference = hash;
+        }
+
+        printf("  %-8zu %14s %12s %10.2f %10.2f %12.1f %9.2fx %18llx%s\n", count, frontToBack ? "front to back" : "back to front",
+          mode == ShadingMode::FORWARD ? "forward" : "visibility",
+          stats.fragments / (pixels * result.iterations), stats.shaded / (pixels * result.iterations),
+          fps, fps / baseline, (unsigned long long)hash, hash == reference ? "" : " MISMATCH");
+      }
+    }
+  }
+
+  rasterizer.setShadingMode(ShadingMode::FORWARD);
+}
+
+void bench::hiz()
+{
+  using namespace a3d::rasterize;
+
+  ThreadPool pool(1);
+  Texture texture(256, 256);
+  texture.generateMipmaps(&pool);
+
+  Buffer2D<u32> colorBuffer(BENCH_WIDTH, BENCH_HEIGHT);
+  RenderTarget target(BENCH_WIDTH, BENCH_HEIGHT);
+  target.bindColor(colorBuffer.data(), colorBuffer.width());
+
+  Rasterizer rasterizer;
+  rasterizer.setTarget(&target);
+  rasterizer.setTexture(&texture);
+  rasterizer.setMipFilter(MipFilter::LINEAR);
+  rasterizer.setTextureFilter(TextureFilter::BILINEAR);
+
+  struct scenario_t { std::string name; std::vector<Triangle> triangles; };
+  std::vector<scenario_t> scenarios;
+
+  for (size_t count : { 2, 4, 8 })
+  {
+    scenarios.push_back({ std::to_string(count) + " layers, back to front", overdrawLayers(count, false) });
+    scenarios.push_back({ std::to_string(count) + " layers, front to back", overdrawLayers(count, true) });
+  }
+
+  /* random overlapping triangles with depths all over the range */
+  for (const auto& generated : { std::make_pair("2000 small", generate(2000, 16.0f, 7)), std::make_pair("200 large", generate(200, 64.0f, 7)) })
+  {
+    std::vector<Triangle> triangles;
+    for (const auto& t : generated.second)
+      triangles.push_back(t.triangle);
+    scenarios.push_back({ generated.first, triangles });
+  }
+
+  printf("  %-26s %6s %10s %10s %12s %10s %18s\n", "scene", "hiz", "rejected", "coarse", "frames/s", "speedup", "checksum");
+
+  for (const auto& scenario : scenarios)
+  {
+    double baseline = 0.0;
+    u64 reference = 0;
+
+    for (bool enabled : { false, true })
+    {
+      rasterizer.setHierarchicalDepth(enabled);
+      rasterizer.resetStats();
+
+      auto result = bench::measure([&]() {
+        target.clear(0, std::numeric_limits<float>::max());
+        for (const auto& triangle : scenario.triangles)
+          rasterizer.draw(triangle);
+        rasterizer.flush();
+      }, 0.3);
+
+      const double fps = result.perSecond(double(result.iterations));
+      const u64 hash = checksum(target);
+      const auto& stats = rasterizer.stats();
+
+      if (!enabled)
+      {
+        baseline = fps;
+        reference = hash;
+      }
+
+      /* rejected is the share of covered fragments failing the depth test, coarse the share of those
+         thrown away a block at a time */
+      printf("  %-26s %6s %9.1f%% %9.1f%% %12.1f %9.2fx %18llx%s\n", scenario.name.c_str(), enabled ? "on" : "off",
+        100.0 * stats.rejected / std::max<u64>(stats.fragments, 1), 100.0 * stats.coarseRejected / std::max<u64>(stats.rejected, 1),
+        fps, fps / baseline, (unsigned long long)hash, hash == reference ? "" : " MISMATCH");
+    }
+  }
+
+  rasterizer.setHierarchicalDepth(true);
+}
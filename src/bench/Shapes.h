@@ -0,0 +1,50 @@
+#pragma once
+
+#include "gfx/VertexProcessor.h"
+
+#include <vector>
+
+namespace bench
+{
+  using namespace a3d;
+
+  /* unit cube with four vertices per face so that each face has its own texture coordinates,
+     faces wind counter clockwise seen from outside */
+  struct cube_t
+  {
+    std::vector<vec3> positions;
+    std::vector<vec2> textureCoords;
+    std::vector<u32> indices;
+    Bounds bounds;
+
+    cube_t()
+    {
+      /* normal followed by two tangents such that u x v = normal */
+      const vec3 faces[][3] = {
+        { vec3(1, 0, 0), vec3(0, 1, 0), vec3(0, 0, 1) },
+        { vec3(-1, 0, 0), vec3(0, 0, 1), vec3(0, 1, 0) },
+        { vec3(0, 1, 0), vec3(0, 0, 1), vec3(1, 0, 0) },
+        { vec3(0, -1, 0), vec3(1, 0, 0), vec3(0, 0, 1) },
+        { vec3(0, 0, 1), vec3(1, 0, 0), vec3(0, 1, 0) },
+        { vec3(0, 0, -1), vec3(0, 1, 0), vec3(1, 0, 0) },
+      };
+
+      for (const auto& face : faces)
+      {
+        const u32 base = u32(positions.size());
+        const vec3 n = face[0], u = face[1], v = face[2];
+
+        positions.insert(positions.end(), { vec3(n - u - v), vec3(n + u - v), vec3(n + u + v), vec3(n - u + v) });
+        textureCoords.insert(textureCoords.end(), { vec2(0, 0), vec2(1, 0), vec2(1, 1), vec2(0, 1) });
+        indices.insert(indices.end(), { base, base + 1, base + 2, base, base + 2, base + 3 });
+      }
+
+      bounds = Bounds::of(positions.data(), positions.size());
+    }
+
+    rasterize::IndexedGeometry geometry() const
+    {
+      return { positions.data(), textureCoords.data(), positions.size(), indices.data(), indices.size(), &bounds };
+    }
+  };
+}
@@ -0,0 +1,563 @@
+#include "Bench.h"
+#include "PerfCounters.h"
+#include "Shapes.h"
+
+#include "gfx/DrawQueue.h"
+#include "gfx/Mesh.h"
+#include "gfx/Scene.h"
+#include "gfx/Teapot.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+
+#include "glm/ext/matrix_transform.hpp"
+#include "glm/ext/matrix_clip_space.hpp"
+#include "glm/gtc/constants.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace a3d;
+using namespace bench;
+
+namespace
+{
+  constexpr coord_t SUITE_WIDTH = 320;
+  constexpr coord_t SUITE_HEIGHT = 240;
+
+  struct options_t
+  {
+    size_t frames = 240;
+    size_t warmup = 16;
+    size_t threads = 1;
+    bool counters = false;
+    bool visibility = false;
+    bool sort = false;
+    bool hierarchicalDepth = true;
+    bool occlusion = false;
+    PixelFormat format = PixelFormat::ARGB8888;
+    const char* json = nullptr;
+    std::vector<const char*> scenes;
+  };
+
+  /* the camera orbits target at distance radius and height above it, its angle around the y axis goes
+     from start to start + sweep over the frames so that every run sees the same views */
+  struct orbit_t
+  {
+    vec3 target;
+    float radius;
+    float height;
+    float start;
+    float sweep;
+
+    mat4 view(float t) const
+    {
+      const float angle = start + sweep * t;
+      const vec3 position = target + vec3(-std::sin(angle) * radius, height, -std::cos(angle) * radius);
+
+      /* turned to face the target, the projection looks down +z like MainView does */
+      mat4 view = glm::rotate(glm::mat4(1.0f), std::atan2(-height, radius), glm::vec3(1, 0, 0));
+      view = glm::rotate(view, -angle, glm::vec3(0, 1, 0));
+      return glm::translate(view, -position);
+    }
+  };
+
+  struct object_t
+  {
+    mat4 model;
+    rasterize::IndexedGeometry geometry;
+    bool occluder;
+  };
+
+  struct scene_t
+  {
+    const char* name;
+    const char* description;
+    orbit_t orbit;
+    std::vector<object_t> objects;
+  };
+
+  /* geometry the scenes point to, it must outlive them */
+  struct assets_t
+  {
+    std::vector<Quad> quads;
+    std::vector<Quad> layers;
+    Mesh teapotMesh;
+    bench::cube_t cube;
+
+    assets_t() : teapotMesh(MeshBuilder::fromSoup(teapot, teapot_count))
+    {
+      /* the quads MainView shows */
+      quads.emplace_back(vec3(-1.0f, -1.0f, 0.0f), 2.0f, 2.0f);
+      quads.emplace_back(vec3(1.0f, -1.0f, 0.0f), 2.0f, 2.0f);
+      quads.emplace_back(vec3(-1.0f, -1.0f, -2.0f), vec3(-1.0f, -1.0f, 0.0f), vec3(-1.0f, 1.0f, -2.0f), vec3(-1.0f, 1.0f, 0.0f));
+
+      /* screen filling layers one behind the other */
+      for (int i = 0; i < 8; ++i)
+        layers.emplace_back(vec3(-6.0f, -4.5f, float(i)), 12.0f, 9.0f);
+    }
+
+    std::vector<scene_t> scenes() const
+    {
+      std::vector<scene_t> scenes;
+      const mat4 identity = mat4(1.0f);
+
+      scenes.push_back({ "quads", "the quads shown by the interactive view", { vec3(0.5f, 0.0f, -0.5f), 5.0f, 0.5f, -0.6f, 1.2f }, { } });
+      for (const auto& quad : quads)
+        scenes.back().objects.push_back({ quad.transform(), quad.geometry(), false });
+
+      scenes.push_back({ "teapot", "the teapot seen from all around", { vec3(0.0f), 4.0f, 1.5f, 0.0f, 2.0f * glm::pi<float>() }, { } });
+      scenes.back().objects.push_back({ identity, teapotMesh.geometry(), false });
+
+      /* a field of small cubes, many of them out of view or too small to cover a pixel */
+      scenes.push_back({ "objects", "a field of 1024 cubes seen from above its border", { vec3(0.0f), 24.0f, 10.0f, 0.0f, 2.0f * glm::pi<float>() }, { } });
+      for (int z = 0; z < 32; ++z)
+        for (int x = 0; x < 32; ++x)
+        {
+          mat4 model = glm::translate(identity, glm::vec3((x - 16) * 1.5f, 0.0f, (z - 16) * 1.5f));
+          model = glm::rotate(model, 0.3f * (x * 7 + z * 3), glm::vec3(0.0f, 1.0f, 0.0f));
+          scenes.back().objects.push_back({ glm::scale(model, glm::vec3(0.4f)), cube.geometry(), false });
+        }
+
+      /* drawn back to front so that every layer passes the depth test, 8 times overdraw */
+      scenes.push_back({ "overdraw", "8 screen filling layers drawn back to front", { vec3(0.0f, 0.0f, 3.5f), 6.0f, 0.0f, -0.2f, 0.4f }, { } });
+      for (auto it = layers.rbegin(); it != layers.rend(); ++it)
+        scenes.back().objects.push_back({ it->transform(), it->geometry(), false });
+
+      /* blocks of buildings 1.6 wide every 3 units with small cubes scattered on the streets between
+         them, seen turning around from the middle of a crossing so that many cubes are behind a wall */
+      scenes.push_back({ "occlusion", "a 6x6 grid of buildings with 301 small cubes on the streets between them", { vec3(0.0f, 0.4f, 0.0f), 0.5f, 0.0f, 0.3f, 2.0f * glm::pi<float>() }, { } });
+      for (int z = 0; z < 6; ++z)
+        for (int x = 0; x < 6; ++x)
+        {
+          const mat4 model = glm::translate(identity, glm::vec3((x - 2.5f) * 3.0f, 1.5f, (z - 2.5f) * 3.0f));
+          scenes.back().objects.push_back({ glm::scale(model, glm::vec3(0.8f, 1.5f, 0.8f)), cube.geometry(), true });
+        }
+
+      for (int z = 0; z < 25; ++z)
+        for (int x = 0; x < 25; ++x)
+        {
+          const float px = (x - 12) * 0.75f, pz = (z - 12) * 0.75f;
+
+          /* skipped inside buildings, which span 0.8 around the centers at 1.5 + 3k */
+          if (std::abs(std::fmod(std::abs(px), 3.0f) - 1.5f) < 1.0f && std::abs(std::fmod(std::abs(pz), 3.0f) - 1.5f) < 1.0f)
+            continue;
+
+          mat4 model = glm::translate(identity, glm::vec3(px, 0.125f, pz));
+          model = glm::rotate(model, 0.3f * (x * 7 + z * 3), glm::vec3(0.0f, 1.0f, 0.0f));
+          scenes.back().objects.push_back({ glm::scale(model, glm::vec3(0.125f)), cube.geometry(), false });
+        }
+
+      return scenes;
+    }
+  };
+
+  using counters_t = PerfCounters::values_t;
+
+  /* hardware counters accumulated per profiler stage */
+  class counter_probe_t : public Profiler::Probe
+  {
+  private:
+    const PerfCounters& _counters;
+    counters_t _start;
+
+  public:
+    std::array<counters_t, Profiler::STAGE_COUNT> totals;
+    std::array<u64, Profiler::STAGE_COUNT> calls;
+
+    counter_probe_t(const PerfCounters& counters) : _counters(counters)
+    {
+      for (auto& total : totals)
+        total.fill(0);
+      calls.fill(0);
+    }
+
+    void begin(Profiler::Stage) override { _start = _counters.read(); }
+
+    void end(Profiler::Stage stage) override
+    {
+      const counters_t now = _counters.read();
+      for (size_t i = 0; i < PerfCounters::EVENT_COUNT; ++i)
+        totals[size_t(stage)][i] += now[i] - _start[i];
+      ++calls[size_t(stage)];
+    }
+  };
+
+  struct result_t
+  {
+    std::vector<double> frameTimes;
+    u64 triangles;
+    u64 fragments;
+    u64 rejected;
+    u64 coarseRejected;
+    u64 shaded;
+    u64 occlusionTested;
+    u64 occlusionCulled;
+    u64 checksum;
+    double seconds;
+
+    /* counts for whole frames and for each stage, if counters were collected */
+    bool counted = false;
+    counters_t frameCounters;
+    std::array<counters_t, Profiler::STAGE_COUNT> stageCounters;
+    std::array<u64, Profiler::STAGE_COUNT> stageCalls;
+
+    /* nearest rank percentile of the sorted frame times */
+    double percentile(double p) const
+    {
+      const size_t rank = size_t(std::ceil(p / 100.0 * frameTimes.size()));
+      return frameTimes[std::min(std::max<size_t>(rank, 1), frameTimes.size()) - 1];
+    }
+  };
+
+  /* of the pixels as ARGB8888 whatever the format of the target, so that runs in every format compare */
+  u64 checksum(const RenderTarget& target)
+  {
+    u64 hash = 14695981039346656037ull;
+    std::vector<u32> row(target.width());
+
+    for (coord_t y = 0; y < target.height(); ++y)
+    {
+      pixels::convert(target.format(), PixelFormat::ARGB8888, target.colorRow(y), row.data(), row.size());
+
+      for (u32 pixel : row)
+        hash = (hash ^ pixel) * 1099511628211ull;
+    }
+
+    return hash;
+  }
+
+  bool parse(int argc, char* argv[], options_t& options)
+  {
+    for (int i = 0; i < argc; ++i)
+    {
+      const bool hasValue = i + 1 < argc;
+
+      if (strcmp(argv[i], "--frames") == 0 && hasValue)
+        options.frames = strtoul(argv[++i], nullptr, 10);
+      else if (strcmp(argv[i], "--warmup") == 0 && hasValue)
+        options.warmup = strtoul(argv[++i], nullptr, 10);
+      else if (strcmp(argv[i], "--threads") == 0 && hasValue)
+        options.threads = strtoul(argv[++i], nullptr, 10);
+      else if (strcmp(argv[i], "--counters") == 0)
+        options.counters = true;
+      else if (strcmp(argv[i], "--no-hiz") == 0)
+        options.hierarchicalDepth = false;
+      else if (strcmp(argv[i], "--occlusion") == 0)
+        options.occlusion = true;
+      else if (strcmp(argv[i], "--sort") == 0)
+        options.sort = true;
+      else if (strcmp(argv[i], "--visibility") == 0)
+        options.visibility = true;
+      else if (strcmp(argv[i], "--format") == 0 && hasValue)
+      {
+        if (!pixels::fromName(argv[++i], options.format))
+          return false;
+      }
+      else if (strcmp(argv[i], "--json") == 0 && hasValue)
+        options.json = argv[++i];
+      else if (argv[i][0] == '-')
+        return false;
+      else
+        options.scenes.push_back(argv[i]);
+    }
+
+    return options.frames > 0 && options.threads > 0;
+  }
+
+  /* text as a quoted JSON string, quotes, backslashes and control characters escaped */
+  void writeString(FILE* out, const char* text)
+  {
+    fputc('"', out);
+
+    for (const char* c = text; *c; ++c)
+    {
+      if (*c == '"' || *c == '\\')
+        fprintf(out, "\\%c", *c);
+      else if (u8(*c) < 0x20)
+        fprintf(out, "\\u%04x", unsigned(u8(*c)));
+      else
+        fputc(*c, out);
+    }
+
+    fputc('"', out);
+  }
+
+  /* counts per frame of the available events, null for the others */
+  void writeCounters(FILE* out, const PerfCounters& counters, const counters_t& values, double frames)
+  {
+    fprintf(out, "{ ");
+
+    for (size_t i = 0; i < PerfCounters::EVENT_COUNT; ++i)
+    {
+      const auto event = PerfCounters::Event(i);
+
+      if (counters.isAvailable(event))
+        fprintf(out, "\"%s\": %.1f, ", PerfCounters::name(event), values[i] / frames);
+      else
+        fprintf(out, "\"%s\": null, ", PerfCounters::name(event));
+    }
+
+    const size_t cycles = size_t(PerfCounters::Event::CYCLES), instructions = size_t(PerfCounters::Event::INSTRUCTIONS);
+
+    if (values[cycles] && counters.isAvailable(PerfCounters::Event::INSTRUCTIONS))
+      fprintf(out, "\"ipc\": %.3f }", double(values[instructions]) / values[cycles]);
+    else
+      fprintf(out, "\"ipc\": null }");
+  }
+
+  void writeJson(FILE* out, const options_t& options, const rasterize::Rasterizer& rasterizer, const PerfCounters& counters,
+    const std::vector<scene_t>& scenes, const std::vector<result_t>& results)
+  {
+    fprintf(out, "{\n");
+    fprintf(out, "  \"width\": %d,\n  \"height\": %d,\n", int(SUITE_WIDTH), int(SUITE_HEIGHT));
+    fprintf(out, "  \"frames\": %zu,\n  \"warmup\": %zu,\n  \"threads\": %zu,\n", options.frames, options.warmup, options.threads);
+    fprintf(out, "  \"shading\": \"%s\",\n", options.visibility ? "visibility" : "forward");
+    fprintf(out, "  \"sorted\": %s,\n", options.sort ? "true" : "false");
+    fprintf(out, "  \"hierarchical_depth\": %s,\n", options.hierarchicalDepth ? "true" : "false");
+    fprintf(out, "  \"occlusion\": %s,\n", options.occlusion ? "true" : "false");
+    fprintf(out, "  \"pixel_format\": \"%s\",\n", pixels::name(options.format));
+    fprintf(out, "  \"coverage\": \"%s\",\n", rasterize::coverage::name(rasterizer.coverageKernel()));
+    fprintf(out, "  \"sampler\": \"%s\",\n", sampler::name(rasterizer.samplerKernel()));
+
+    if (options.counters && counters.isOpen())
+    {
+      fprintf(out, "  \"counters\": { \"available\": true },\n");
+    }
+    else if (options.counters)
+    {
+      fprintf(out, "  \"counters\": { \"available\": false, \"error\": ");
+      writeString(out, counters.error().c_str());
+      fprintf(out, " },\n");
+    }
+
+    fprintf(out, "  \"scenes\": [\n");
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+      const result_t& r = results[i];
+      const double frames = double(r.frameTimes.size());
+
+      fprintf(out, "    {\n");
+      fprintf(out, "      \"name\": ");
+      writeString(out, scenes[i].name);
+      fprintf(out, ",\n");
+      fprintf(out, "      \"frame_ms\": { \"mean\": %.4f, \"min\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f },\n",
+        r.seconds / frames * 1e3, r.frameTimes.front() * 1e3, r.percentile(50) * 1e3, r.percentile(90) * 1e3, r.percentile(99) * 1e3, r.frameTimes.back() * 1e3);
+      fprintf(out, "      \"triangles_per_frame\": %.1f,\n", r.triangles / frames);
+      fprintf(out, "      \"fragments_per_frame\": %.1f,\n", r.fragments / frames);
+      fprintf(out, "      \"rejected_per_frame\": %.1f,\n", r.rejected / frames);
+      fprintf(out, "      \"depth_rejection\": %.4f,\n", r.fragments ? double(r.rejected) / r.fragments : 0.0);
+      fprintf(out, "      \"coarse_rejected_per_frame\": %.1f,\n", r.coarseRejected / frames);
+      fprintf(out, "      \"shaded_per_frame\": %.1f,\n", r.shaded / frames);
+      fprintf(out, "      \"occlusion_tested_per_frame\": %.1f,\n", r.occlusionTested / frames);
+      fprintf(out, "      \"occlusion_culled_per_frame\": %.1f,\n", r.occlusionCulled / frames);
+      fprintf(out, "      \"triangles_per_second\": %.0f,\n", r.triangles / r.seconds);
+      fprintf(out, "      \"fragments_per_second\": %.0f,\n", r.fragments / r.seconds);
+      fprintf(out, "      \"checksum\": \"%016llx\"%s\n", (unsigned long long)r.checksum, r.counted ? "," : "");
+
+      if (r.counted)
+      {
+        fprintf(out, "      \"counters\": {\n");
+        fprintf(out, "        \"frame\": ");
+        writeCounters(out, counters, r.frameCounters, frames);
+
+        for (size_t s = 0; s < Profiler::STAGE_COUNT; ++s)
+        {
+          if (!r.stageCalls[s])
+            continue;
+
+          fprintf(out, ",\n        \"%s\": ", Profiler::name(Profiler::Stage(s)));
+          writeCounters(out, counters, r.stageCounters[s], frames);
+        }
+
+        fprintf(out, "\n      }\n");
+      }
+      fprintf(out, "    }%s\n", i + 1 < results.size() ? "," : "");
+    }
+
+    fprintf(out, "  ]\n}\n");
+  }
+}
+
+int bench::suite(int argc, char* argv[])
+{
+  options_t options;
+
+  if (!parse(argc, argv, options))
+  {
+    printf("Usage: --suite [--frames n] [--warmup n] [--threads n] [--counters] [--sort] [--occlusion] [--no-hiz] [--visibility] [--format argb8888|rgba8888] [--json path] [scene...]\n");
+    return -1;
+  }
+
+  const assets_t assets;
+  std::vector<scene_t> scenes = assets.scenes();
+
+  if (!options.scenes.empty())
+  {
+    scenes.erase(std::remove_if(scenes.begin(), scenes.end(), [&options](const scene_t& scene) {
+      return std::none_of(options.scenes.begin(), options.scenes.end(), [&scene](const char* name) { return strcmp(name, scene.name) == 0; });
+    }), scenes.end());
+
+    if (scenes.empty())
+    {
+      printf("Unknown scene, available ones:\n");
+      for (const auto& scene : assets.scenes())
+        printf("  %-12s %s\n", scene.name, scene.description);
+      return -1;
+    }
+  }
+
+  /* declared before the texture and the target are created, they capture it */
+  pixels::setFormat(options.format);
+
+  /* the same texture settings as the interactive view, but generated so that runs don't depend on files */
+  ThreadPool pool(options.threads);
+  Texture texture(256, 256);
+  texture.setLayout(TexelLayout::MORTON);
+  texture.generateMipmaps(&pool);
+
+  Buffer2D<u32> colorBuffer(SUITE_WIDTH, SUITE_HEIGHT);
+  RenderTarget target(SUITE_WIDTH, SUITE_HEIGHT);
+  target.bindColor(colorBuffer.data(), colorBuffer.width());
+
+  rasterize::Rasterizer rasterizer;
+  rasterizer.setTarget(&target);
+  rasterizer.setTexture(&texture);
+  rasterizer.setMipFilter(MipFilter::LINEAR);
+  rasterizer.setTextureFilter(TextureFilter::BILINEAR);
+  rasterizer.setThreadPool(options.threads > 1 ? &pool : nullptr);
+  rasterizer.setHierarchicalDepth(options.hierarchicalDepth);
+  rasterizer.setShadingMode(options.visibility ? rasterize::ShadingMode::VISIBILITY : rasterize::ShadingMode::FORWARD);
+
+  rasterize::VertexProcessor processor(&rasterizer);
+  rasterize::DrawQueue queue(0.01f, 100.0f);
+  queue.setSorting(options.sort);
+
+  /* a quarter of the resolution on each axis, 4800 pixels */
+  rasterize::OcclusionCuller culler(SUITE_WIDTH / 4, SUITE_HEIGHT / 4);
+  queue.setOcclusionCuller(options.occlusion ? &culler : nullptr);
+
+  glm::mat4 projection = glm::perspective(glm::radians(60.0f), float(SUITE_WIDTH) / float(SUITE_HEIGHT), 0.01f, 100.0f);
+  projection = glm::rotate(projection, glm::pi<float>(), glm::vec3(0, 1, 0));
+
+  PerfCounters counters;
+
+  if (options.counters && !counters.open())
+    printf("Hardware counters unavailable, %s.\n", counters.error().c_str());
+
+  /* the table goes to stdout unless it's where the json goes */
+  const bool table = options.json != nullptr;
+  std::vector<result_t> results;
+
+  if (table)
+    printf("  %-10s %8s %8s %8s %8s %12s %12s %18s\n", "scene", "mean ms", "p50", "p99", "max", "Mtris/s", "Mfrags/s", "checksum");
+
+  for (const auto& scene : scenes)
+  {
+    auto frame = [&](size_t index) {
+      const mat4 viewProjection = projection * scene.orbit.view(float(index) / options.frames);
+
+      target.clear(0, std::numeric_limits<float>::max());
+      for (const auto& object : scene.objects)
+        queue.add(viewProjection * object.model, object.geometry, object.occluder);
+      queue.submit(processor);
+      rasterizer.flush();
+    };
+
+    /* the warm up follows the same path so that caches and buffers are in their steady state */
+    for (size_t i = 0; i < options.warmup; ++i)
+      frame(i * options.frames / options.warmup);
+
+    result_t result;
+    result.frameTimes.reserve(options.frames);
+    rasterizer.resetStats();
+    culler.resetStats();
+
+    for (size_t i = 0; i < options.frames; ++i)
+    {
+      Timer timer;
+      frame(i);
+      result.frameTimes.push_back(timer.seconds());
+    }
+
+    result.seconds = 0.0;
+    for (double time : result.frameTimes)
+      result.seconds += time;
+
+    std::sort(result.frameTimes.begin(), result.frameTimes.end());
+    result.triangles = rasterizer.stats().triangles;
+    result.fragments = rasterizer.stats().fragments;
+    result.rejected = rasterizer.stats().rejected;
+    result.coarseRejected = rasterizer.stats().coarseRejected;
+    result.shaded = rasterizer.stats().shaded;
+    result.occlusionTested = culler.stats().tested;
+    result.occlusionCulled = culler.stats().culled;
+    result.checksum = checksum(target);
+
+    if (table)
+      printf("  %-10s %8.3f %8.3f %8.3f %8.3f %12.3f %12.3f %18llx\n", scene.name, result.seconds / options.frames * 1e3,
+        result.percentile(50) * 1e3, result.percentile(99) * 1e3, result.frameTimes.back() * 1e3,
+        result.triangles / result.seconds / 1e6, result.fragments / result.seconds / 1e6, (unsigned long long)result.checksum);
+
+    /* counters are collected on a second pass over the same frames, reading them at every stage
+       boundary costs system calls which would otherwise show in the frame times */
+    if (counters.isOpen())
+    {
+      counter_probe_t probe(counters);
+      Profiler::setEnabled(true);
+      Profiler::setProbe(&probe);
+
+      result.frameCounters.fill(0);
+
+      for (size_t i = 0; i < options.frames; ++i)
+      {
+        const counters_t before = counters.read();
+        frame(i);
+        const counters_t after = counters.read();
+
+        for (size_t e = 0; e < PerfCounters::EVENT_COUNT; ++e)
+          result.frameCounters[e] += after[e] - before[e];
+      }
+
+      Profiler::setProbe(nullptr);
+      Profiler::setEnabled(false);
+
+      result.counted = true;
+      result.stageCounters = probe.totals;
+      result.stageCalls = probe.calls;
+
+      if (table)
+      {
+        const size_t cycles = size_t(PerfCounters::Event::CYCLES), instructions = size_t(PerfCounters::Event::INSTRUCTIONS);
+
+        printf("  %-10s", "");
+        for (size_t s = 0; s < Profiler::STAGE_COUNT; ++s)
+          if (result.stageCalls[s] && result.stageCounters[s][cycles])
+            printf(" %s %.2f ipc", Profiler::name(Profiler::Stage(s)), double(result.stageCounters[s][instructions]) / result.stageCounters[s][cycles]);
+        printf("\n");
+      }
+    }
+
+    results.push_back(std::move(result));
+  }
+
+  FILE* out = options.json ? fopen(options.json, "w") : stdout;
+
+  if (!out)
+  {
+    printf("Error while writing %s.\n", options.json);
+    return -1;
+  }
+
+  writeJson(out, options, rasterizer, counters, scenes, results);
+
+  if (out != stdout)
+    fclose(out);
+
+  return 0;
+}
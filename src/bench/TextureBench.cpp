@@ -0,0 +1,314 @@
+#include "Bench.h"
+
+#include "gfx/Rasterizer.h"
+#include "gfx/Sampler.h"
+#include "ThreadPool.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace a3d;
+
+namespace
+{
+  constexpr size_t TEXTURE_SIZE = 2048;
+  constexpr size_t SCREEN_WIDTH = 640;
+  constexpr size_t SCREEN_HEIGHT = 480;
+
+  /* samples a screen worth of pixels from the texture rotated by angle around its center, texels
+     per pixel gives the minification, returns a checksum of the samples */
+  u32 sampleRotated(const Texture& texture, float angle, float texelsPerPixel)
+  {
+    const float scale = texelsPerPixel / texture.width();
+    const vec2 du = vec2(std::cos(angle), std::sin(angle)) * scale;
+    const vec2 dv = vec2(-du.y, du.x);
+    const vec2 origin = vec2(0.5f) - du * (SCREEN_WIDTH * 0.5f) - dv * (SCREEN_HEIGHT * 0.5f);
+
+    u32 sum = 0;
+
+    for (size_t y = 0; y < SCREEN_HEIGHT; ++y)
+    {
+      vec2 coords = origin + dv * float(y);
+
+      for (size_t x = 0; x < SCREEN_WIDTH; ++x, coords += du)
+        sum += texture.sample(coords);
+    }
+
+    return sum;
+  }
+
+  /* screen aligned square of side size pixels centered on the target plus offset, mapping the whole texture */
+  void drawSquare(rasterize::Rasterizer& rasterizer, float size, float offset)
+  {
+    const float cx = rasterizer.viewport().w * 0.5f + offset, cy = rasterizer.viewport().h * 0.5f;
+    const float h = size * 0.5f;
+
+    const vec4 corners[] = { vec4(cx - h, cy - h, 0.5f, 1.0f), vec4(cx + h, cy - h, 0.5f, 1.0f), vec4(cx - h, cy + h, 0.5f, 1.0f), vec4(cx + h, cy + h, 0.5f, 1.0f) };
+    const vec2 coords[] = { vec2(0.0f, 0.0f), vec2(1.0f, 0.0f), vec2(0.0f, 1.0f), vec2(1.0f, 1.0f) };
+
+    for (const auto& indices : { std::array<size_t, 3>{ 0, 1, 2 }, std::array<size_t, 3>{ 1, 3, 2 } })
+    {
+      rasterize::Triangle triangle;
+      for (size_t i = 0; i < 3; ++i)
+        triangle.vertices[i] = corners[indices[i]];
+      triangle.setVarying(0, std::array<vec2, 3>{ coords[indices[0]], coords[indices[1]], coords[indices[2]] });
+      rasterizer.draw(triangle);
+    }
+
+    rasterizer.flush();
+  }
+}
+
+void bench::texlayout()
+{
+  const struct { TexelLayout layout; const char* name; } layouts[] = {
+    { TexelLayout::LINEAR, "linear" },
+    { TexelLayout::TILED, "tiled" },
+    { TexelLayout::MORTON, "morton" },
+  };
+
+  Texture texture(TEXTURE_SIZE, TEXTURE_SIZE);
+
+  for (float texelsPerPixel : { 1.0f, 2.5f })
+  {
+    printf("  %.1f texels per pixel, Msamples/s\n", texelsPerPixel);
+    printf("    %-8s", "angle");
+    for (const auto& layout : layouts)
+      printf(" %10s", layout.name);
+    printf("\n");
+
+    for (int degrees = 0; degrees <= 90; degrees += 15)
+    {
+      const float angle = degrees * 3.14159265f / 180.0f;
+      u32 reference = 0;
+      bool mismatch = false;
+
+      printf("    %-8d", degrees);
+
+      for (const auto& layout : layouts)
+      {
+        texture.setLayout(layout.layout);
+
+        u32 sum = 0;
+        auto result = bench::measure([&]() { sum = sampleRotated(texture, angle, texelsPerPixel); }, 0.2);
+
+        if (layout.layout == TexelLayout::LINEAR)
+          reference = sum;
+        mismatch |= sum != reference;
+
+        printf(" %10.1f", result.perSecond(double(result.iterations) * SCREEN_WIDTH * SCREEN_HEIGHT) / 1e6);
+      }
+
+      printf("%s\n", mismatch ? " MISMATCH" : "");
+    }
+  }
+}
+
+void bench::mipmap()
+{
+  constexpr coord_t WIDTH = 512, HEIGHT = 512;
+
+  const struct { MipFilter mipFilter; TextureFilter filter; const char* name; } filters[] = {
+    { MipFilter::NONE, TextureFilter::NEAREST, "none" },
+    { MipFilter::NEAREST, TextureFilter::NEAREST, "nearest" },
+    { MipFilter::LINEAR, TextureFilter::BILINEAR, "trilinear" },
+  };
+
+  Texture texture(TEXTURE_SIZE, TEXTURE_SIZE);
+  texture.setLayout(TexelLayout::TILED);
+
+  {
+    ThreadPool pool(std::max<size_t>(std::thread::hardware_concurrency(), 1));
+    Texture serial(TEXTURE_SIZE, TEXTURE_SIZE);
+
+    auto single = bench::measure([&]() { serial.generateMipmaps(); }, 0.2);
+    auto parallel = bench::measure([&]() { texture.generateMipmaps(&pool); }, 0.2);
+
+    printf("  %zu levels, generated in %.2f ms on one thread and %.2f ms on %zu\n", texture.levelCount(),
+      single.seconds / single.iterations * 1e3, parallel.seconds / parallel.iterations * 1e3, pool.size());
+  }
+
+  std::vector<u32> colors(WIDTH * HEIGHT), reference(WIDTH * HEIGHT);
+  RenderTarget target(WIDTH, HEIGHT);
+  target.bindColor(colors.data(), WIDTH);
+
+  rasterize::Rasterizer rasterizer;
+  rasterizer.setTarget(&target);
+  rasterizer.setTexture(&texture);
+
+  /* error is the mean difference per channel from a reference which averages 8x8 point samples of the
+     base level per pixel, aliasing shows up as pixels picking single texels out of a larger footprint */
+  printf("  %-8s %10s %12s %12s %10s\n", "texels", "filter", "frames/s", "Mfrags/s", "error");
+
+  for (float texelsPerPixel : { 1.0f, 3.0f, 12.0f, 40.0f })
+  {
+    const float size = TEXTURE_SIZE / texelsPerPixel;
+    const float x0 = WIDTH * 0.5f - size * 0.5f, y0 = HEIGHT * 0.5f - size * 0.5f;
+
+    for (coord_t y = 0; y < HEIGHT; ++y)
+      for (coord_t x = 0; x < WIDTH; ++x)
+      {
+        u32 sum[4] = { 0, 0, 0, 0 };
+
+        for (u32 sy = 0; sy < 8; ++sy)
+          for (u32 sx = 0; sx < 8; ++sx)
+          {
+            const vec2 coords = vec2(x + (sx + 0.5f) / 8 - x0, y + (sy + 0.5f) / 8 - y0) / size;
+            const u32 texel = texture.sample(coords);
+            for (u32 c = 0; c < 4; ++c)
+              sum[c] += (texel >> (c * 8)) & 0xFF;
+          }
+
+        reference[y * WIDTH + x] = (sum[0] / 64) | ((sum[1] / 64) << 8) | ((sum[2] / 64) << 16) | ((sum[3] / 64) << 24);
+      }
+
+    for (const auto& filter : filters)
+    {
+      rasterizer.setMipFilter(filter.mipFilter);
+      rasterizer.setTextureFilter(filter.filter);
+      rasterizer.resetStats();
+
+      auto result = bench::measure([&]() {
+        target.clear(0, std::numeric_limits<float>::max());
+        drawSquare(rasterizer, size, 0.0f);
+      }, 0.2);
+
+      /* only pixels fully inside the square are compared, the reference doesn't know about coverage */
+      u64 difference = 0, channels = 0;
+      for (coord_t y = std::max(coord_t(y0) + 1, 0); y < std::min(coord_t(y0 + size) - 1, HEIGHT); ++y)
+        for (coord_t x = std::max(coord_t(x0) + 1, 0); x < std::min(coord_t(x0 + size) - 1, WIDTH); ++x)
+          for (u32 shift = 0; shift < 24; shift += 8, ++channels)
+            difference += std::abs(int32_t((colors[y * WIDTH + x] >> shift) & 0xff) - int32_t((reference[y * WIDTH + x] >> shift) & 0xff));
+
+      printf("  %-8.0f %10s %12.1f %12.2f %10.2f\n", texelsPerPixel, filter.name, result.perSecond(double(result.iterations)),
+        result.perSecond(double(rasterizer.stats().fragments)) / 1e6, channels ? double(difference) / channels : 0.0);
+    }
+  }
+
+  target.unbindColor();
+}
+
+void bench::bilinear()
+{
+  constexpr size_t COUNT = 4096;
+
+  const SamplerKernel kernels[] = { SamplerKernel::SCALAR, SamplerKernel::SSE2, SamplerKernel::AVX2, SamplerKernel::AVX2_GATHER };
+
+  /* coordinates walk rows of a screen rotated over the texture as in texlayout, in batches like the
+     rows the rasterizer shades */
+  std::vector<float> u(COUNT), v(COUNT);
+  std::vector<u32> colors(COUNT);
+
+  for (size_t i = 0; i < COUNT; ++i)
+  {
+    const float x = float(i % 64) - 32.0f, y = float(i / 64) - 32.0f;
+    u[i] = 0.5f + (x * 0.8f - y * 0.6f) * 0.0037f;
+    v[i] = 0.5f + (x * 0.6f + y * 0.8f) * 0.0037f;
+  }
+
+  auto checksum = [&colors]() {
+    u64 hash = 0;
+    for (u32 color : colors)
+      hash = hash * 31 + color;
+    return hash;
+  };
+
+  for (size_t size : { size_t(256), size_t(2048) })
+  {
+    Texture texture(size, size);
+    texture.setLayout(TexelLayout::TILED);
+
+    printf("  %zux%zu texture\n", size, size);
+    printf("    %-12s %12s %10s %18s\n", "kernel", "Msamples/s", "cost", "checksum");
+
+    auto nearest = bench::measure([&]() {
+      for (size_t i = 0; i < COUNT; ++i)
+        colors[i] = texture.sample(vec2(u[i], v[i]));
+    }, 0.2);
+
+    const double nearestRate = nearest.perSecond(double(nearest.iterations) * COUNT);
+    printf("    %-12s %12.1f %9.2fx %18llx\n", "nearest", nearestRate / 1e6, 1.0, (unsigned long long)checksum());
+
+    u64 reference = 0;
+
+    for (SamplerKernel kernel : kernels)
+    {
+      if (!sampler::isSupported(kernel))
+        continue;
+
+      const bilinear_function_t function = sampler::function(kernel);
+
+      /* batches of 32 like the rows of a tile */
+      auto result = bench::measure([&]() {
+        for (size_t i = 0; i < COUNT; i += 32)
+          function(texture, u.data() + i, v.data() + i, 32, colors.data() + i);
+      }, 0.2);
+
+      const u64 hash = checksum();
+      if (kernel == SamplerKernel::SCALAR)
+        reference = hash;
+
+      const double rate = result.perSecond(double(result.iterations) * COUNT);
+      printf("    %-12s %12.1f %9.2fx %18llx%s\n", sampler::name(kernel), rate / 1e6, nearestRate / rate, (unsigned long long)hash, hash == reference ? "" : " MISMATCH");
+    }
+  }
+}
+
+void bench::texload()
+{
+  constexpr int SIZE = 4096;
+  const double bytes = double(SIZE) * SIZE * sizeof(u32);
+
+  printf("  %dx%d atlas, %.0f MB\n", SIZE, SIZE, bytes / (1 << 20));
+  printf("    %-24s %10s %10s\n", "path", "ms", "GB/s");
+
+  auto report = [bytes](const char* name, const bench::measure_t& result) {
+    const double seconds = result.seconds / result.iterations;
+    printf("    %-24s %10.2f %10.2f\n", name, seconds * 1e3, bytes / seconds / 1e9);
+  };
+
+  /* the declared format, the other format we support and one SDL has to convert */
+  const PixelFormat format = pixels::format();
+  const PixelFormat other = format == PixelFormat::ARGB8888 ? PixelFormat::RGBA8888 : PixelFormat::ARGB8888;
+
+  SDL_Surface* native = SDL_CreateRGBSurfaceWithFormat(0, SIZE, SIZE, 32, pixels::sdlFormat(format));
+  SDL_Surface* swizzled = SDL_CreateRGBSurfaceWithFormat(0, SIZE, SIZE, 32, pixels::sdlFormat(other));
+  SDL_Surface* foreign = SDL_CreateRGBSurfaceWithFormat(0, SIZE, SIZE, 32, SDL_PIXELFORMAT_ABGR8888);
+
+  for (SDL_Surface* surface : { native, swizzled, foreign })
+    for (int i = 0; i < SIZE * SIZE; ++i)
+      static_cast<u32*>(surface->pixels)[i] = u32(i) * 2654435761u;
+
+  /* what every load has to do at least */
+  std::vector<u32> copy(SIZE * SIZE);
+  report("memcpy", bench::measure([&]() { std::memcpy(copy.data(), native->pixels, copy.size() * sizeof(u32)); }, 0.2));
+
+  /* the previous loader: conversion to RGBA8888 then SDL_GetRGBA for every pixel */
+  std::vector<color_t> colors(SIZE * SIZE);
+  report("per pixel SDL_GetRGBA", bench::measure([&]() {
+    auto* format = SDL_AllocFormat(SDL_PIXELFORMAT_RGBA8888);
+    auto* surface = SDL_ConvertSurface(native, format, 0);
+    SDL_FreeFormat(format);
+
+    for (int y = 0; y < SIZE; ++y)
+      for (int x = 0; x < SIZE; ++x)
+      {
+        auto& color = colors[y * SIZE + x];
+        SDL_GetRGBA(static_cast<u32*>(surface->pixels)[x + y * SIZE], surface->format, &color.r, &color.g, &color.b, &color.a);
+      }
+
+    SDL_FreeSurface(surface);
+  }, 0.2));
+
+  Texture texture(1, 1);
+  report("load, same format", bench::measure([&]() { texture.load(native); }, 0.2));
+  report("load, swizzled", bench::measure([&]() { texture.load(swizzled); }, 0.2));
+  report("load, converted by SDL", bench::measure([&]() { texture.load(foreign); }, 0.2));
+
+  SDL_FreeSurface(native);
+  SDL_FreeSurface(swizzled);
+  SDL_FreeSurface(foreign);
+}
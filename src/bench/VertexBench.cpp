@@ -0,0 +1,325 @@
+#include "Bench.h"
+#include "Shapes.h"
+
+#include "gfx/DrawQueue.h"
+#include "gfx/VertexProcessor.h"
+#include "gfx/Mesh.h"
+#include "gfx/Teapot.h"
+
+#include "glm/ext/matrix_transform.hpp"
+#include "glm/ext/matrix_clip_space.hpp"
+
+#include <cmath>
+#include <vector>
+
+using namespace a3d;
+
+namespace
+{
+  constexpr coord_t BENCH_WIDTH = 320;
+  constexpr coord_t BENCH_HEIGHT = 240;
+
+  /* a flat grid of cells x cells quads in [-1, 1], two triangles per quad sharing their diagonal */
+  struct grid_t
+  {
+    std::vector<vec3> positions;
+    std::vector<vec2> textureCoords;
+    std::vector<u32> indices;
+    Bounds bounds;
+
+    grid_t(u32 cells)
+    {
+      for (u32 y = 0; y <= cells; ++y)
+        for (u32 x = 0; x <= cells; ++x)
+        {
+          positions.push_back(vec3(-1.0f + 2.0f * x / cells, -1.0f + 2.0f * y / cells, 0.0f));
+          textureCoords.push_back(vec2(float(x) / cells, float(y) / cells));
+        }
+
+      for (u32 y = 0; y < cells; ++y)
+        for (u32 x = 0; x < cells; ++x)
+        {
+          const u32 i = y * (cells + 1) + x;
+          indices.insert(indices.end(), { i, i + 1, i + cells + 1, i + 1, i + cells + 2, i + cells + 1 });
+        }
+
+      bounds = Bounds::of(positions.data(), positions.size());
+    }
+
+    rasterize::IndexedGeometry geometry() const
+    {
+      return { positions.data(), textureCoords.data(), positions.size(), indices.data(), indices.size(), &bounds };
+    }
+  };
+}
+
+void bench::vertices()
+{
+  Texture texture(128, 128);
+  Buffer2D<u32> colorBuffer(BENCH_WIDTH, BENCH_HEIGHT);
+  RenderTarget target(BENCH_WIDTH, BENCH_HEIGHT);
+  target.bindColor(colorBuffer.data(), colorBuffer.width());
+
+  rasterize::Rasterizer rasterizer;
+  rasterizer.setTarget(&target);
+  rasterizer.setTexture(&texture);
+
+  rasterize::VertexProcessor processor(&rasterizer);
+
+  const mat4 projection = glm::perspective(glm::radians(60.0f), float(BENCH_WIDTH) / float(BENCH_HEIGHT), 0.01f, 100.0f);
+  const mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -2.5f));
+  const mat4 model = glm::rotate(glm::mat4(1.0f), 0.5f, glm::vec3(1.0f, 0.0f, 0.0f));
+
+  printf("  %-8s %10s %10s %14s %14s %10s\n", "cells", "vertices", "path", "Mtris/s", "Mxforms/s", "speedup");
+
+  for (u32 cells : { 16u, 64u, 160u })
+  {
+    const grid_t grid(cells);
+    const size_t triangles = grid.indices.size() / 3;
+
+    /* the original MainView loop, the matrix product is computed and the vertices transformed for each triangle */
+    auto perTriangle = bench::measure([&]() {
+      target.clear(0, std::numeric_limits<float>::max());
+      for (size_t i = 0; i < grid.indices.size(); i += 3)
+      {
+        const mat4 transform = projection * view * model;
+        std::array<vec4, 3> vertices;
+        std::array<vec2, 3> textureCoords;
+
+        for (size_t k = 0; k < 3; ++k)
+        {
+          vertices[k] = transform * vec4(grid.positions[grid.indices[i + k]], 1.0f);
+          textureCoords[k] = grid.textureCoords[grid.indices[i + k]];
+        }
+
+        auto triangle = rasterizer.projectRectangle(vertices);
+        triangle.setVarying(0, textureCoords);
+        rasterizer.draw(triangle);
+      }
+      rasterizer.flush();
+    });
+
+    auto indexed = bench::measure([&]() {
+      target.clear(0, std::numeric_limits<float>::max());
+      processor.draw(projection * view * model, grid.geometry());
+      rasterizer.flush();
+    });
+
+    printf("  %-8u %10zu %10s %14.3f %14.3f %10s\n", cells, grid.positions.size(), "triangle",
+      perTriangle.perSecond(double(perTriangle.iterations * triangles)) / 1e6,
+      perTriangle.perSecond(double(perTriangle.iterations * triangles * 3)) / 1e6, "");
+    printf("  %-8u %10zu %10s %14.3f %14.3f %9.2fx\n", cells, grid.positions.size(), "indexed",
+      indexed.perSecond(double(indexed.iterations * triangles)) / 1e6,
+      indexed.perSecond(double(indexed.iterations * grid.positions.size())) / 1e6,
+      indexed.perSecond(double(indexed.iterations)) / perTriangle.perSecond(double(perTriangle.iterations)));
+  }
+
+  /* the teapot as the triangle soup it's stored as versus welded into an indexed mesh, far enough
+     that vertex processing dominates */
+  stream_t<vec3> positions(teapot_count / 3), normals(teapot_count / 3);
+  stream_t<vec2> textureCoords(teapot_count / 3);
+  std::vector<u32> indices(teapot_count / 3);
+
+  for (size_t i = 0; i < positions.size(); ++i)
+  {
+    positions[i] = vec3(teapot[i * 3], teapot[i * 3 + 1], teapot[i * 3 + 2]);
+    indices[i] = u32(i);
+  }
+
+  const Mesh meshes[] = {
+    Mesh(std::move(positions), std::move(normals), std::move(textureCoords), IndexBuffer(indices.data(), indices.size(), indices.size())),
+    MeshBuilder::fromSoup(teapot, teapot_count)
+  };
+  const char* names[] = { "soup", "welded" };
+
+  const mat4 teapotView = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -16.0f));
+
+  printf("\n  %-8s %10s %10s %14s %14s %10s\n", "teapot", "vertices", "bytes", "Mtris/s", "Mxforms/s", "speedup");
+
+  double baseline = 0.0;
+
+  for (size_t i = 0; i < 2; ++i)
+  {
+    const Mesh& mesh = meshes[i];
+
+    auto result = bench::measure([&]() {
+      target.clear(0, std::numeric_limits<float>::max());
+      processor.draw(projection * teapotView * model, mesh.geometry());
+      rasterizer.flush();
+    });
+
+    const double fps = result.perSecond(double(result.iterations));
+    if (i == 0)
+      baseline = fps;
+
+    printf("  %-8s %10zu %10zu %14.3f %14.3f %9.2fx\n", names[i], mesh.vertexCount(), mesh.sizeInBytes(),
+      result.perSecond(double(result.iterations * mesh.triangleCount())) / 1e6,
+      result.perSecond(double(result.iterations * mesh.vertexCount())) / 1e6, fps / baseline);
+  }
+}
+
+void bench::culling()
+{
+  Texture texture(128, 128);
+  Buffer2D<u32> colorBuffer(BENCH_WIDTH, BENCH_HEIGHT);
+  RenderTarget target(BENCH_WIDTH, BENCH_HEIGHT);
+  target.bindColor(colorBuffer.data(), colorBuffer.width());
+
+  rasterize::Rasterizer rasterizer;
+  rasterizer.setTarget(&target);
+  rasterizer.setTexture(&texture);
+
+  rasterize::VertexProcessor processor(&rasterizer);
+
+  /* a field of cubes all around the camera, most of them out of the view */
+  const cube_t cube;
+  const int side = 40;
+  std::vector<mat4> models;
+
+  for (int z = 0; z < side; ++z)
+    for (int x = 0; x < side; ++x)
+    {
+      const glm::vec3 position = glm::vec3((x - side / 2) * 2.0f, -1.0f, (z - side / 2) * 2.0f);
+      glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+      model = glm::rotate(model, 0.1f * (x + z), glm::vec3(0.0f, 1.0f, 0.0f));
+      models.push_back(glm::scale(model, glm::vec3(0.25f)));
+    }
+
+  const mat4 viewProjection = glm::perspective(glm::radians(60.0f), float(BENCH_WIDTH) / float(BENCH_HEIGHT), 0.01f, 100.0f);
+
+  struct mode_t { const char* name; bool frustum; bool backFace; };
+  const mode_t modes[] = {
+    { "none", false, false },
+    { "backface", false, true },
+    { "frustum", true, false },
+    { "both", true, true },
+  };
+
+  printf("  %-10s %10s %12s %12s %12s %12s %10s\n", "culling", "frames/s", "objects", "culled", "triangles", "backfacing", "speedup");
+
+  double baseline = 0.0;
+
+  for (const auto& mode : modes)
+  {
+    processor.setFrustumCulling(mode.frustum);
+    processor.setBackFaceCulling(mode.backFace);
+    processor.resetStats();
+
+    auto result = bench::measure([&]() {
+      target.clear(0, std::numeric_limits<float>::max());
+      for (const auto& model : models)
+        processor.draw(viewProjection * model, cube.geometry());
+      rasterizer.flush();
+    });
+
+    const double fps = result.perSecond(double(result.iterations));
+    if (!mode.frustum && !mode.backFace)
+      baseline = fps;
+
+    const auto& stats = processor.stats();
+    printf("  %-10s %10.1f %12llu %12llu %12llu %12llu %9.2fx\n", mode.name, fps,
+      (unsigned long long)(stats.objects / result.iterations), (unsigned long long)(stats.culledObjects / result.iterations),
+      (unsigned long long)(stats.triangles / result.iterations), (unsigned long long)(stats.backFacing / result.iterations), fps / baseline);
+  }
+}
+
+void bench::occlusion()
+{
+  Texture texture(128, 128);
+  Buffer2D<u32> colorBuffer(BENCH_WIDTH, BENCH_HEIGHT);
+  RenderTarget target(BENCH_WIDTH, BENCH_HEIGHT);
+  target.bindColor(colorBuffer.data(), colorBuffer.width());
+
+  rasterize::Rasterizer rasterizer;
+  rasterizer.setTarget(&target);
+  rasterizer.setTexture(&texture);
+
+  rasterize::VertexProcessor processor(&rasterizer);
+  rasterize::DrawQueue queue;
+  queue.setSorting(false);
+
+  rasterize::OcclusionCuller culler(BENCH_WIDTH / 4, BENCH_HEIGHT / 4);
+
+  /* a grid of buildings with small cubes on the streets between them, every 0.5 units */
+  const cube_t cube;
+  std::vector<mat4> buildings, objects;
+
+  for (int z = 0; z < 8; ++z)
+    for (int x = 0; x < 8; ++x)
+    {
+      const mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3((x - 3.5f) * 3.0f, 1.0f, (z - 3.5f) * 3.0f));
+      buildings.push_back(glm::scale(model, glm::vec3(0.8f, 2.0f, 0.8f)));
+    }
+
+  for (int z = 0; z < 48; ++z)
+    for (int x = 0; x < 48; ++x)
+    {
+      const float px = (x - 24) * 0.5f, pz = (z - 24) * 0.5f;
+
+      if (std::abs(std::fmod(std::abs(px), 3.0f) - 1.5f) < 1.0f && std::abs(std::fmod(std::abs(pz), 3.0f) - 1.5f) < 1.0f)
+        continue;
+
+      objects.push_back(glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(px, -0.8f, pz)), glm::vec3(0.1f)));
+    }
+
+  /* turning around at eye level from the middle of a crossing */
+  const mat4 projection = glm::perspective(glm::radians(60.0f), float(BENCH_WIDTH) / float(BENCH_HEIGHT), 0.01f, 100.0f);
+  const size_t views = 16;
+
+  auto viewProjection = [&](size_t view) {
+    const mat4 rotation = glm::rotate(glm::mat4(1.0f), 6.2831853f * view / views, glm::vec3(0.0f, 1.0f, 0.0f));
+    return projection * glm::translate(rotation, glm::vec3(0.0f, 0.5f, 0.0f));
+  };
+
+  printf("  %d buildings, %d objects, %dx%d occlusion buffer\n", int(buildings.size()), int(objects.size()), int(culler.width()), int(culler.height()));
+  printf("  %-10s %10s %12s %12s %12s %10s\n", "occlusion", "frames/s", "drawn", "occluded", "cull ms", "speedup");
+
+  double baseline = 0.0;
+
+  for (bool enabled : { false, true })
+  {
+    queue.setOcclusionCuller(enabled ? &culler : nullptr);
+    processor.resetStats();
+    culler.resetStats();
+
+    size_t frame = 0;
+    auto result = bench::measure([&]() {
+      const mat4 vp = viewProjection(frame++ % views);
+
+      target.clear(0, std::numeric_limits<float>::max());
+      for (const auto& model : buildings)
+        queue.add(vp * model, cube.geometry(), true);
+      for (const auto& model : objects)
+        queue.add(vp * model, cube.geometry());
+      queue.submit(processor);
+      rasterizer.flush();
+    });
+
+    const u64 occluded = culler.stats().culled;
+
+    /* the culling pass alone over the same views */
+    double cullSeconds = 0.0;
+    if (enabled)
+    {
+      frame = 0;
+      auto cull = bench::measure([&]() {
+        const mat4 vp = viewProjection(frame++ % views);
+
+        culler.clear();
+        for (const auto& model : buildings)
+          culler.addOccluder(vp * model, cube.geometry());
+        for (const auto& model : objects)
+          culler.isVisible(vp * model, cube.bounds);
+      });
+      cullSeconds = cull.seconds / cull.iterations;
+    }
+
+    const double fps = result.perSecond(double(result.iterations));
+    if (!enabled)
+      baseline = fps;
+
+    printf("  %-10s %10.1f %12llu %12llu %12.3f %9.2fx\n", enabled ? "enabled" : "none", fps,
+      (unsigned long long)(processor.stats().objects / result.iterations), (unsigned long long)(occluded / result.iterations),
+      cullSeconds * 1e3, fps / baseline);
+  }
+}
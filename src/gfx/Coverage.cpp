@@ -0,0 +1,159 @@
+#include "Coverage.h"
+
+#include "SDL.h"
+
+#if A3D_X86
+#include <emmintrin.h>
+#endif
+
+#include <cstdlib>
+
+using namespace a3d::rasterize;
+
+namespace
+{
+  constexpr int64_t HALF_PIXEL = SUBPIXEL_STEP / 2;
+
+  inline int64_t center(coord_t v) { return int64_t(v) * SUBPIXEL_STEP + HALF_PIXEL; }
+
+  inline u32 widthMask(coord_t width) { return width >= 32 ? ~0u : (1u << width) - 1; }
+}
+
+void coverage::scalar(const EdgeEquations& e, coord_t x, coord_t y, coord_t width, coord_t height, u32* masks)
+{
+  const int64_t px = center(x);
+  const int64_t stepX0 = e.a[0] * SUBPIXEL_STEP, stepX1 = e.a[1] * SUBPIXEL_STEP, stepX2 = e.a[2] * SUBPIXEL_STEP;
+
+  for (coord_t r = 0; r < height; ++r)
+  {
+    const int64_t py = center(y + r);
+    int64_t w0 = e.a[0] * px + e.b[0] * py + e.c[0];
+    int64_t w1 = e.a[1] * px + e.b[1] * py + e.c[1];
+    int64_t w2 = e.a[2] * px + e.b[2] * py + e.c[2];
+
+    u32 mask = 0;
+
+    for (coord_t i = 0; i < width; ++i)
+    {
+      if ((w0 | w1 | w2) >= 0)
+        mask |= 1u << i;
+
+      w0 += stepX0;
+      w1 += stepX1;
+      w2 += stepX2;
+    }
+
+    masks[r] = mask;
+  }
+}
+
+#if A3D_X86
+void coverage::sse2(const EdgeEquations& e, coord_t x, coord_t y, coord_t width, coord_t height, u32* masks)
+{
+  const int64_t px = center(x);
+
+  __m128i lanes[3], steps[3];
+  for (size_t i = 0; i < 3; ++i)
+  {
+    const int32_t step = int32_t(e.a[i] * SUBPIXEL_STEP);
+    lanes[i] = _mm_setr_epi32(0, step, 2 * step, 3 * step);
+    steps[i] = _mm_set1_epi32(4 * step);
+  }
+
+  for (coord_t r = 0; r < height; ++r)
+  {
+    const int64_t py = center(y + r);
+
+    __m128i w0 = _mm_add_epi32(_mm_set1_epi32(int32_t(e.a[0] * px + e.b[0] * py + e.c[0])), lanes[0]);
+    __m128i w1 = _mm_add_epi32(_mm_set1_epi32(int32_t(e.a[1] * px + e.b[1] * py + e.c[1])), lanes[1]);
+    __m128i w2 = _mm_add_epi32(_mm_set1_epi32(int32_t(e.a[2] * px + e.b[2] * py + e.c[2])), lanes[2]);
+
+    u32 mask = 0;
+
+    for (coord_t i = 0; i < width; i += 4)
+    {
+      /* a lane is covered when none of the three sign bits is set */
+      const __m128i any = _mm_or_si128(_mm_or_si128(w0, w1), w2);
+      mask |= u32(~_mm_movemask_ps(_mm_castsi128_ps(any)) & 0xF) << i;
+
+      w0 = _mm_add_epi32(w0, steps[0]);
+      w1 = _mm_add_epi32(w1, steps[1]);
+      w2 = _mm_add_epi32(w2, steps[2]);
+    }
+
+    masks[r] = mask & widthMask(width);
+  }
+}
+#endif
+
+bool coverage::fitsVectorRange(const EdgeEquations& e, coord_t x, coord_t y, coord_t height)
+{
+  /* edge functions are linear so their extremes over the block are at its corners, the block is
+     widened to the farthest lane a kernel can evaluate and values are kept below 2^30 so that
+     differences between lanes fit too */
+  constexpr int64_t LIMIT = int64_t(1) << 30;
+
+  const int64_t xs[2] = { center(x), center(x + MAX_WIDTH - 1) };
+  const int64_t ys[2] = { center(y), center(y + height - 1) };
+
+  for (size_t i = 0; i < 3; ++i)
+    for (int64_t px : xs)
+      for (int64_t py : ys)
+      {
+        const int64_t w = e.a[i] * px + e.b[i] * py + e.c[i];
+        if (w >= LIMIT || w <= -LIMIT)
+          return false;
+      }
+
+  return true;
+}
+
+bool coverage::isSupported(CoverageKernel kernel)
+{
+  switch (kernel)
+  {
+  case CoverageKernel::SCALAR: return true;
+#if A3D_X86
+  case CoverageKernel::SSE2: return SDL_HasSSE2();
+  case CoverageKernel::AVX2: return SDL_HasAVX2();
+#endif
+  default: return false;
+  }
+}
+
+CoverageKernel coverage::best()
+{
+  if (isSupported(CoverageKernel::AVX2))
+    return CoverageKernel::AVX2;
+  else if (isSupported(CoverageKernel::SSE2))
+    return CoverageKernel::SSE2;
+  else
+    return CoverageKernel::SCALAR;
+}
+
+coverage_function_t coverage::function(CoverageKernel kernel)
+{
+  if (!isSupported(kernel))
+    return nullptr;
+
+  switch (kernel)
+  {
+#if A3D_X86
+  case CoverageKernel::SSE2: return &sse2;
+  case CoverageKernel::AVX2: return &avx2;
+#endif
+  default: return &scalar;
+  }
+}
+
+const char* coverage::name(CoverageKernel kernel)
+{
+  switch (kernel)
+  {
+  case CoverageKernel::SCALAR: return "scalar";
+  case CoverageKernel::SSE2: return "sse2";
+  case CoverageKernel::AVX2: return "avx2";
+  }
+
+  return "unknown";
+}
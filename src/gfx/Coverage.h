@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Common.h"
+
+namespace a3d
+{
+  namespace rasterize
+  {
+    /* screen space vertices are snapped to a 1/16th of pixel grid before traversal */
+    constexpr int32_t SUBPIXEL_BITS = 4;
+    constexpr int32_t SUBPIXEL_STEP = 1 << SUBPIXEL_BITS;
+
+    /* the three edge functions of a triangle, E_i(p) = a[i] * p.x + b[i] * p.y + c[i] with p
+       expressed in sub-pixel units; a pixel is covered when all of them are non negative at its center */
+    struct EdgeEquations
+    {
+      int64_t a[3], b[3], c[3];
+    };
+
+    enum class CoverageKernel
+    {
+      SCALAR,
+      SSE2,
+      AVX2
+    };
+
+    /* computes coverage of a block of at most 32 x height pixels starting at (x, y), writing a mask
+       per row where bit i stands for pixel x + i. Vectorized kernels work on 32 bit lanes so they
+       must be used only when fitsVectorRange is true for the block */
+    using coverage_function_t = void(*)(const EdgeEquations& edges, coord_t x, coord_t y, coord_t width, coord_t height, u32* masks);
+
+    namespace coverage
+    {
+      constexpr coord_t MAX_WIDTH = 32;
+
+      void scalar(const EdgeEquations& edges, coord_t x, coord_t y, coord_t width, coord_t height, u32* masks);
+#if A3D_X86
+      void sse2(const EdgeEquations& edges, coord_t x, coord_t y, coord_t width, coord_t height, u32* masks);
+      void avx2(const EdgeEquations& edges, coord_t x, coord_t y, coord_t width, coord_t height, u32* masks);
+#endif
+
+      /* true if every value the vectorized kernels may compute for the block fits 32 bit lanes */
+      bool fitsVectorRange(const EdgeEquations& edges, coord_t x, coord_t y, coord_t height);
+
+      bool isSupported(CoverageKernel kernel);
+      /* best kernel supported by the cpu we're running on */
+      CoverageKernel best();
+      coverage_function_t function(CoverageKernel kernel);
+      const char* name(CoverageKernel kernel);
+    }
+  }
+}
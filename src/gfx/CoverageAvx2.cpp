@@ -0,0 +1,63 @@
+#include "Coverage.h"
+
+#if A3D_X86
+
+#include <immintrin.h>
+
+/* this is the only translation unit allowed to emit AVX2 instructions, it is compiled for it
+   without requiring the whole project to be, the kernel is picked at runtime only if supported */
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+using namespace a3d::rasterize;
+
+void coverage::avx2(const EdgeEquations& e, coord_t x, coord_t y, coord_t width, coord_t height, u32* masks)
+{
+  const int64_t px = int64_t(x) * SUBPIXEL_STEP + SUBPIXEL_STEP / 2;
+  const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+  __m256i lanes[3], steps[3];
+  for (size_t i = 0; i < 3; ++i)
+  {
+    const int32_t step = int32_t(e.a[i] * SUBPIXEL_STEP);
+    lanes[i] = _mm256_mullo_epi32(lane, _mm256_set1_epi32(step));
+    steps[i] = _mm256_set1_epi32(8 * step);
+  }
+
+  const u32 valid = width >= 32 ? ~0u : (1u << width) - 1;
+
+  for (coord_t r = 0; r < height; ++r)
+  {
+    const int64_t py = int64_t(y + r) * SUBPIXEL_STEP + SUBPIXEL_STEP / 2;
+
+    __m256i w0 = _mm256_add_epi32(_mm256_set1_epi32(int32_t(e.a[0] * px + e.b[0] * py + e.c[0])), lanes[0]);
+    __m256i w1 = _mm256_add_epi32(_mm256_set1_epi32(int32_t(e.a[1] * px + e.b[1] * py + e.c[1])), lanes[1]);
+    __m256i w2 = _mm256_add_epi32(_mm256_set1_epi32(int32_t(e.a[2] * px + e.b[2] * py + e.c[2])), lanes[2]);
+
+    u32 mask = 0;
+
+    for (coord_t i = 0; i < width; i += 8)
+    {
+      const __m256i any = _mm256_or_si256(_mm256_or_si256(w0, w1), w2);
+      mask |= u32(~_mm256_movemask_ps(_mm256_castsi256_ps(any)) & 0xFF) << i;
+
+      w0 = _mm256_add_epi32(w0, steps[0]);
+      w1 = _mm256_add_epi32(w1, steps[1]);
+      w2 = _mm256_add_epi32(w2, steps[2]);
+    }
+
+    masks[r] = mask & valid;
+  }
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Scene.h"
+#include "TextureCache.h"
+#include "Rasterizer.h"
+#include "DrawQueue.h"
+#include "RenderTarget.h"
+#include "VertexProcessor.h"
+
+#include <memory>
+#include <vector>
+
+namespace a3d
+{
+  /* the scene the engine shows, kept apart from any window so that the same frames can be drawn into
+     a window or into memory on machines without a display */
+  class DemoScene
+  {
+  private:
+    Camera _camera;
+
+    TextureCache _textures;
+    std::shared_ptr<const Texture> _texture;
+    Texture _missingTexture;
+
+    rasterize::Rasterizer _rasterizer;
+    rasterize::VertexProcessor _vertexProcessor;
+    rasterize::DrawQueue _drawQueue;
+
+    std::vector<Quad> _quads;
+
+  public:
+    /* textures and rasterization run on the pool if present */
+    DemoScene(ThreadPool* pool);
+
+    /* clears target and draws a frame into it, its color plane must be bound. Opaque draws go through
+       the draw queue, sorted front to back unless sorting is turned off on it */
+    void render(RenderTarget& target);
+
+    Camera& camera() { return _camera; }
+    rasterize::Rasterizer& rasterizer() { return _rasterizer; }
+    rasterize::DrawQueue& drawQueue() { return _drawQueue; }
+  };
+}
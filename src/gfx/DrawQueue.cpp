@@ -0,0 +1,107 @@
+#include "DrawQueue.h"
+
+#include "Profiler.h"
+
+#include <algorithm>
+
+using namespace a3d;
+using namespace a3d::rasterize;
+
+u32 DrawQueue::key(const mat4& mvp, const IndexedGeometry& geometry) const
+{
+  constexpr u32 maxKey = (1u << KEY_BITS) - 1;
+
+  if (!geometry.bounds)
+    return maxKey;
+
+  const float depth = (mvp * vec4(geometry.bounds->center, 1.0f)).w;
+  const float t = std::clamp((depth - _near) / (_far - _near), 0.0f, 1.0f);
+
+  return u32(t * maxKey);
+}
+
+void DrawQueue::add(const mat4& mvp, const IndexedGeometry& geometry, bool occluder)
+{
+  _draws.push_back({ mvp, geometry, occluder });
+
+  if (_sorting)
+    _keys.push_back(key(mvp, geometry));
+}
+
+void DrawQueue::sort()
+{
+  constexpr u32 buckets = 1u << DIGIT_BITS;
+  const size_t count = _draws.size();
+
+  _order.resize(count);
+  _scratch.resize(count);
+
+  for (size_t i = 0; i < count; ++i)
+    _order[i] = u32(i);
+
+  for (u32 shift = 0; shift < KEY_BITS; shift += DIGIT_BITS)
+  {
+    size_t offsets[buckets] = { };
+
+    for (u32 index : _order)
+      ++offsets[(_keys[index] >> shift) & (buckets - 1)];
+
+    size_t offset = 0;
+    for (size_t& bucket : offsets)
+    {
+      const size_t size = bucket;
+      bucket = offset;
+      offset += size;
+    }
+
+    for (u32 index : _order)
+      _scratch[offsets[(_keys[index] >> shift) & (buckets - 1)]++] = index;
+
+    std::swap(_order, _scratch);
+  }
+}
+
+void DrawQueue::cull()
+{
+  ProfileScope scope(Profiler::Stage::OCCLUSION);
+
+  _culler->clear();
+
+  for (const auto& draw : _draws)
+    if (draw.occluder)
+      _culler->addOccluder(draw.mvp, draw.geometry);
+
+  /* occluders are never tested, they'd be hidden by themselves */
+  _visible.resize(_draws.size());
+  for (size_t i = 0; i < _draws.size(); ++i)
+  {
+    const draw_t& draw = _draws[i];
+    _visible[i] = draw.occluder || !draw.geometry.bounds || _culler->isVisible(draw.mvp, *draw.geometry.bounds);
+  }
+}
+
+void DrawQueue::submit(VertexProcessor& processor)
+{
+  if (_culler)
+    cull();
+  else
+    _visible.assign(_draws.size(), 1);
+
+  if (_sorting && _keys.size() == _draws.size())
+  {
+    sort();
+
+    for (u32 index : _order)
+      if (_visible[index])
+        processor.draw(_draws[index].mvp, _draws[index].geometry);
+  }
+  else
+  {
+    for (size_t i = 0; i < _draws.size(); ++i)
+      if (_visible[i])
+        processor.draw(_draws[i].mvp, _draws[i].geometry);
+  }
+
+  _draws.clear();
+  _keys.clear();
+}
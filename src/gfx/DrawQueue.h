@@ -0,0 +1,74 @@
+#pragma once
+
+#include "OcclusionCuller.h"
+
+#include <vector>
+
+namespace a3d
+{
+  namespace rasterize
+  {
+    /* opaque draws collected over a frame and submitted front to back, so that the depth test rejects
+       hidden fragments before they're shaded instead of after. Each draw is keyed on the view depth of
+       its bounds center, the w it gets in clip space, quantized to KEY_BITS over the depth range; keys
+       are ordered by a least significant digit radix sort which is stable, so draws falling in the same
+       bucket keep the order they were added in. Draws without bounds go last.
+
+       With an occlusion culler attached, draws flagged as occluders are rasterized into it first and
+       every other draw with bounds is tested against it, those found hidden are dropped */
+    class DrawQueue
+    {
+    public:
+      static constexpr u32 KEY_BITS = 16;
+      static constexpr u32 DIGIT_BITS = 8;
+
+    private:
+      struct draw_t
+      {
+        mat4 mvp;
+        IndexedGeometry geometry;
+        bool occluder;
+      };
+
+      std::vector<draw_t> _draws;
+
+      /* kept between frames so that sorting doesn't allocate once grown */
+      std::vector<u32> _keys;
+      std::vector<u32> _order;
+      std::vector<u32> _scratch;
+      std::vector<u8> _visible;
+
+      OcclusionCuller* _culler;
+
+      float _near, _far;
+      bool _sorting;
+
+      u32 key(const mat4& mvp, const IndexedGeometry& geometry) const;
+      void sort();
+      void cull();
+
+    public:
+      DrawQueue(float near = 0.01f, float far = 100.0f) : _culler(nullptr), _near(near), _far(far), _sorting(true) { }
+
+      /* range of view depths the keys are spread over, nearer and farther draws clamp to its ends */
+      void setDepthRange(float near, float far) { _near = near; _far = far; }
+
+      /* without sorting draws are submitted in the order they were added */
+      void setSorting(bool enabled) { _sorting = enabled; }
+      bool isSorting() const { return _sorting; }
+
+      /* culler is cleared and filled on every submit, null disables occlusion culling */
+      void setOcclusionCuller(OcclusionCuller* culler) { _culler = culler; }
+      OcclusionCuller* occlusionCuller() const { return _culler; }
+
+      /* geometry must stay alive until the queue is submitted, occluders are meant to be large and
+         simple objects hiding others, like walls or terrain */
+      void add(const mat4& mvp, const IndexedGeometry& geometry, bool occluder = false);
+
+      /* draws everything queued through processor and empties the queue */
+      void submit(VertexProcessor& processor);
+
+      size_t size() const { return _draws.size(); }
+    };
+  }
+}
@@ -0,0 +1,150 @@
+#include "FrameRecorder.h"
+
+#include <cstring>
+
+using namespace a3d;
+
+FrameRecorder::FrameRecorder() : _format(ImageFormat::PPM), _policy(Policy::DROP), _size({ 0, 0 }), _pixelFormat(PixelFormat::ARGB8888),
+  _queueHead(0), _queueCount(0), _recording(false), _stopping(false), _frame(0), _stats()
+{
+}
+
+bool FrameRecorder::start(const path& prefix, ImageFormat format, const RenderTarget& target, size_t depth, Policy policy, u32 fps)
+{
+  stop();
+
+  if (format == ImageFormat::Y4M && !_video.open(prefix + images::extension(format), target.width(), target.height(), fps))
+    return false;
+
+  _prefix = prefix;
+  _format = format;
+  _policy = policy;
+  _size = target.size();
+  _pixelFormat = target.format();
+
+  _buffers.assign(std::max<size_t>(depth, 1), std::vector<u32>(_size.w * _size.h));
+  _free.clear();
+  for (size_t i = 0; i < _buffers.size(); ++i)
+    _free.push_back(i);
+
+  _queue.resize(_buffers.size());
+  _queueHead = 0;
+  _queueCount = 0;
+
+  _frame = 0;
+  _stats = Stats();
+  _stopping = false;
+  _recording = true;
+
+  _writer = std::thread([this]() { write(); });
+
+  return true;
+}
+
+void FrameRecorder::stop()
+{
+  if (!_recording)
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(_lock);
+    _stopping = true;
+  }
+
+  _queued.notify_one();
+  _writer.join();
+
+  if (_video.isOpen() && !_video.close())
+    ++_stats.failed;
+
+  _recording = false;
+}
+
+void FrameRecorder::capture(const RenderTarget& target)
+{
+  if (!_recording)
+    return;
+
+  assert(target.hasColor() && target.width() == _size.w && target.height() == _size.h);
+
+  std::unique_lock<std::mutex> lock(_lock);
+  const u64 frame = _frame++;
+
+  if (_free.empty())
+  {
+    if (_policy == Policy::DROP)
+    {
+      ++_stats.dropped;
+      return;
+    }
+
+    ++_stats.stalls;
+    _released.wait(lock, [this]() { return !_free.empty(); });
+  }
+
+  const size_t buffer = _free.back();
+  _free.pop_back();
+
+  /* the copy happens outside of the lock, the writer doesn't touch buffers which aren't queued */
+  lock.unlock();
+
+  u32* destination = _buffers[buffer].data();
+  for (coord_t y = 0; y < _size.h; ++y)
+    std::memcpy(destination + y * _size.w, target.colorRow(y), _size.w * sizeof(u32));
+
+  lock.lock();
+  _queue[(_queueHead + _queueCount++) % _queue.size()] = { buffer, frame };
+  ++_stats.captured;
+  lock.unlock();
+
+  _queued.notify_one();
+}
+
+void FrameRecorder::write()
+{
+  std::unique_lock<std::mutex> lock(_lock);
+
+  for (;;)
+  {
+    _queued.wait(lock, [this]() { return _stopping || _queueCount > 0; });
+
+    if (_queueCount == 0)
+      break;
+
+    const job_t job = _queue[_queueHead];
+    _queueHead = (_queueHead + 1) % _queue.size();
+    --_queueCount;
+
+    lock.unlock();
+    const bool success = encode(job);
+    lock.lock();
+
+    if (success)
+      ++_stats.written;
+    else
+      ++_stats.failed;
+
+    _free.push_back(job.buffer);
+    _released.notify_one();
+  }
+}
+
+bool FrameRecorder::encode(const job_t& job)
+{
+  const image_view_t image = { _buffers[job.buffer].data(), size_t(_size.w), _size.w, _size.h, _pixelFormat };
+
+  if (_format == ImageFormat::Y4M)
+    return _video.write(image);
+
+  char number[16];
+  snprintf(number, sizeof(number), "_%06llu", (unsigned long long)job.frame);
+  const path path = _prefix + number + images::extension(_format);
+
+  return _format == ImageFormat::PNG ? images::writePng(path, image) : images::writePpm(path, image);
+}
+
+FrameRecorder::Stats FrameRecorder::stats() const
+{
+  std::lock_guard<std::mutex> lock(_lock);
+  return _stats;
+}
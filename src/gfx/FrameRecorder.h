@@ -0,0 +1,95 @@
+#pragma once
+
+#include "ImageFile.h"
+#include "RenderTarget.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace a3d
+{
+  /* records the frames of a render target without blocking the thread which draws them. A capture
+     copies the color plane into one of a fixed number of buffers and queues it, a background thread
+     encodes queued frames and gives their buffers back.
+
+     When every buffer is in use the capture either drops the frame or waits for the writer to free a
+     buffer, depending on the policy. No allocation happens after start() */
+  class FrameRecorder
+  {
+  public:
+    enum class Policy
+    {
+      /* the frame is lost, for interactive recording where frame time matters more */
+      DROP,
+      /* the drawing thread waits, for offline rendering where every frame matters */
+      STALL
+    };
+
+    struct Stats
+    {
+      u64 captured;
+      u64 written;
+      u64 dropped;
+      u64 stalls;
+      u64 failed;
+    };
+
+  private:
+    struct job_t
+    {
+      size_t buffer;
+      u64 frame;
+    };
+
+    path _prefix;
+    ImageFormat _format;
+    Policy _policy;
+    size2d_t _size;
+    PixelFormat _pixelFormat;
+
+    std::vector<std::vector<u32>> _buffers;
+    std::vector<size_t> _free;
+
+    /* ring of queued jobs, sized once to the number of buffers which bounds the jobs in flight */
+    std::vector<job_t> _queue;
+    size_t _queueHead;
+    size_t _queueCount;
+
+    Y4mWriter _video;
+
+    std::thread _writer;
+    mutable std::mutex _lock;
+    std::condition_variable _queued;
+    std::condition_variable _released;
+    bool _recording;
+    bool _stopping;
+
+    u64 _frame;
+    Stats _stats;
+
+    void write();
+    bool encode(const job_t& job);
+
+  public:
+    FrameRecorder();
+    ~FrameRecorder() { stop(); }
+
+    FrameRecorder(const FrameRecorder&) = delete;
+    FrameRecorder& operator=(const FrameRecorder&) = delete;
+
+    /* images are written to prefix followed by the frame number and the extension, video to prefix
+       followed by the extension. Returns false if the output can't be created */
+    bool start(const path& prefix, ImageFormat format, const RenderTarget& target, size_t depth = 8, Policy policy = Policy::DROP, u32 fps = 60);
+    /* waits until every queued frame has been written */
+    void stop();
+
+    bool isRecording() const { return _recording; }
+
+    /* queues the color plane of target, which must be bound and as large as the one recording started with */
+    void capture(const RenderTarget& target);
+
+    Stats stats() const;
+  };
+}
@@ -0,0 +1,31 @@
+#include "FrameSink.h"
+
+using namespace a3d;
+
+SdlSink::~SdlSink()
+{
+  if (_texture)
+    SDL_DestroyTexture(_texture);
+}
+
+bool SdlSink::begin(RenderTarget& target)
+{
+  /* created on first use so that the sink can be built before the renderer has anything to show */
+  if (!_texture)
+    _texture = SDL_CreateTexture(_renderer, pixels::sdlFormat(target.format()), SDL_TEXTUREACCESS_STREAMING, target.width(), target.height());
+
+  void* pixels;
+  int pitch;
+
+  if (!_texture || SDL_LockTexture(_texture, nullptr, &pixels, &pitch) != 0)
+    return false;
+
+  target.bindColor(static_cast<u32*>(pixels), pitch / sizeof(u32));
+  return true;
+}
+
+void SdlSink::end(RenderTarget& target)
+{
+  target.unbindColor();
+  SDL_UnlockTexture(_texture);
+}
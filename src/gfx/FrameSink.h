@@ -0,0 +1,72 @@
+#pragma once
+
+#include "RenderTarget.h"
+
+#include "SDL.h"
+
+namespace a3d
+{
+  /* destination of the frames the software rasterizer produces. A sink provides the memory the color
+     plane of a target is bound to for the length of a frame, so that pixels are written where they
+     end up instead of being copied there afterwards, then takes the finished frame back */
+  class FrameSink
+  {
+  public:
+    virtual ~FrameSink() { }
+
+    /* binds the color plane of target, returns false if there's nowhere to draw this frame */
+    virtual bool begin(RenderTarget& target) = 0;
+    /* unbinds the color plane and hands the frame on */
+    virtual void end(RenderTarget& target) = 0;
+  };
+
+  /* frames stay in a plain buffer in memory, which is all we need to render without a display */
+  class MemorySink : public FrameSink
+  {
+  private:
+    Buffer2D<u32> _pixels;
+    u64 _frames;
+
+  public:
+    MemorySink(coord_t width, coord_t height) : _pixels(width, height), _frames(0) { }
+
+    bool begin(RenderTarget& target) override
+    {
+      assert(target.width() == coord_t(_pixels.width()) && target.height() == coord_t(_pixels.height()));
+      target.bindColor(_pixels.data(), _pixels.width());
+      return true;
+    }
+
+    void end(RenderTarget& target) override
+    {
+      target.unbindColor();
+      ++_frames;
+    }
+
+    /* the last finished frame, in the format of the target it was drawn to */
+    const u32* row(size_t y) const { return _pixels.row(y); }
+    const u32* data() const { return _pixels.data(); }
+    coord_t width() const { return _pixels.width(); }
+    coord_t height() const { return _pixels.height(); }
+
+    u64 frames() const { return _frames; }
+  };
+
+  /* frames are drawn into a streaming texture of an SDL renderer, the rasterizer writes straight into
+     its locked pixels and texture() can be blitted once the frame has ended */
+  class SdlSink : public FrameSink
+  {
+  private:
+    SDL_Renderer* _renderer;
+    SDL_Texture* _texture;
+
+  public:
+    SdlSink(SDL_Renderer* renderer) : _renderer(renderer), _texture(nullptr) { }
+    ~SdlSink();
+
+    bool begin(RenderTarget& target) override;
+    void end(RenderTarget& target) override;
+
+    SDL_Texture* texture() const { return _texture; }
+  };
+}
@@ -0,0 +1,160 @@
+#include "ImageFile.h"
+
+#include "SDL_image.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace a3d;
+
+bool images::writePpm(const path& path, const image_view_t& image)
+{
+  FILE* file = fopen(path.c_str(), "wb");
+
+  if (!file)
+    return false;
+
+  fprintf(file, "P6\n%d %d\n255\n", int(image.width), int(image.height));
+
+  const auto shifts = pixels::shifts(image.format);
+  std::vector<u8> row(image.width * 3);
+  bool success = true;
+
+  for (coord_t y = 0; y < image.height; ++y)
+  {
+    const u32* pixels = image.row(y);
+
+    for (coord_t x = 0; x < image.width; ++x)
+    {
+      row[x * 3 + 0] = u8(pixels[x] >> shifts.r);
+      row[x * 3 + 1] = u8(pixels[x] >> shifts.g);
+      row[x * 3 + 2] = u8(pixels[x] >> shifts.b);
+    }
+
+    success &= fwrite(row.data(), 1, row.size(), file) == row.size();
+  }
+
+  success &= fclose(file) == 0;
+  return success;
+}
+
+bool images::writePng(const path& path, const image_view_t& image)
+{
+  /* the surface only wraps the pixels, SDL_image reads them in their format */
+  SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom(const_cast<u32*>(image.pixels), int(image.width), int(image.height), 32,
+    int(image.pitch * sizeof(u32)), pixels::sdlFormat(image.format));
+
+  if (!surface)
+    return false;
+
+  const bool success = IMG_SavePNG(surface, path.c_str()) == 0;
+  SDL_FreeSurface(surface);
+
+  return success;
+}
+
+const char* images::extension(ImageFormat format)
+{
+  switch (format)
+  {
+    case ImageFormat::PPM: return ".ppm";
+    case ImageFormat::PNG: return ".png";
+    case ImageFormat::Y4M: return ".y4m";
+  }
+
+  return "";
+}
+
+bool images::formatFor(const path& path, ImageFormat& format)
+{
+  for (ImageFormat candidate : { ImageFormat::PPM, ImageFormat::PNG, ImageFormat::Y4M })
+  {
+    const size_t length = strlen(extension(candidate));
+
+    if (path.size() > length && path.compare(path.size() - length, length, extension(candidate)) == 0)
+    {
+      format = candidate;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool Y4mWriter::open(const path& path, coord_t width, coord_t height, u32 fps)
+{
+  close();
+
+  _file = fopen(path.c_str(), "wb");
+
+  if (!_file)
+    return false;
+
+  _width = width;
+  _height = height;
+  _planes.resize(width * height + 2 * ((width + 1) / 2) * ((height + 1) / 2));
+
+  return fprintf(_file, "YUV4MPEG2 W%d H%d F%u:1 Ip A1:1 C420jpeg\n", int(width), int(height), fps) > 0;
+}
+
+bool Y4mWriter::write(const image_view_t& image)
+{
+  assert(image.width == _width && image.height == _height);
+
+  if (!_file)
+    return false;
+
+  const auto shifts = pixels::shifts(image.format);
+  const coord_t chromaWidth = (_width + 1) / 2, chromaHeight = (_height + 1) / 2;
+
+  u8* luma = _planes.data();
+  u8* cb = luma + _width * _height;
+  u8* cr = cb + chromaWidth * chromaHeight;
+
+  /* weights are in 16.16 fixed point */
+  for (coord_t y = 0; y < _height; ++y)
+  {
+    const u32* row = image.row(y);
+
+    for (coord_t x = 0; x < _width; ++x)
+    {
+      const int r = (row[x] >> shifts.r) & 0xFF, g = (row[x] >> shifts.g) & 0xFF, b = (row[x] >> shifts.b) & 0xFF;
+      luma[y * _width + x] = u8((19595 * r + 38470 * g + 7471 * b + 32768) >> 16);
+    }
+  }
+
+  for (coord_t cy = 0; cy < chromaHeight; ++cy)
+    for (coord_t cx = 0; cx < chromaWidth; ++cx)
+    {
+      int r = 0, g = 0, b = 0;
+
+      /* the last row and column are repeated when the size is odd */
+      for (coord_t dy = 0; dy < 2; ++dy)
+        for (coord_t dx = 0; dx < 2; ++dx)
+        {
+          const u32 p = image.row(std::min(cy * 2 + dy, _height - 1))[std::min(cx * 2 + dx, _width - 1)];
+          r += (p >> shifts.r) & 0xFF;
+          g += (p >> shifts.g) & 0xFF;
+          b += (p >> shifts.b) & 0xFF;
+        }
+
+      cb[cy * chromaWidth + cx] = u8(std::clamp((-11059 * r - 21709 * g + 32768 * b + (128 << 18) + (1 << 17)) >> 18, 0, 255));
+      cr[cy * chromaWidth + cx] = u8(std::clamp((32768 * r - 27439 * g - 5329 * b + (128 << 18) + (1 << 17)) >> 18, 0, 255));
+    }
+
+  bool success = fputs("FRAME\n", _file) >= 0;
+  success &= fwrite(_planes.data(), 1, _planes.size(), _file) == _planes.size();
+
+  return success;
+}
+
+bool Y4mWriter::close()
+{
+  if (!_file)
+    return true;
+
+  const bool success = fclose(_file) == 0;
+  _file = nullptr;
+
+  return success;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "PixelFormat.h"
+
+#include <cstdio>
+#include <vector>
+
+namespace a3d
+{
+  enum class ImageFormat { PPM, PNG, Y4M };
+
+  /* pixels as a render target holds them, pitch is expressed in pixels */
+  struct image_view_t
+  {
+    const u32* pixels;
+    size_t pitch;
+    coord_t width;
+    coord_t height;
+    PixelFormat format;
+
+    const u32* row(size_t y) const { return pixels + y * pitch; }
+  };
+
+  namespace images
+  {
+    /* binary PPM, the simplest format any image tool opens, alpha is dropped */
+    bool writePpm(const path& path, const image_view_t& image);
+    /* encoded by SDL_image */
+    bool writePng(const path& path, const image_view_t& image);
+
+    const char* extension(ImageFormat format);
+    /* returns false if path doesn't end with the extension of a format we write */
+    bool formatFor(const path& path, ImageFormat& format);
+  }
+
+  /* YUV4MPEG2 stream, uncompressed video that ffmpeg and most encoders read. Frames are converted to
+     full range BT.601 with chroma averaged over 2x2 pixels (C420jpeg) */
+  class Y4mWriter
+  {
+  private:
+    FILE* _file;
+    coord_t _width, _height;
+    std::vector<u8> _planes;
+
+  public:
+    Y4mWriter() : _file(nullptr), _width(0), _height(0) { }
+    ~Y4mWriter() { close(); }
+
+    Y4mWriter(const Y4mWriter&) = delete;
+    Y4mWriter& operator=(const Y4mWriter&) = delete;
+
+    bool open(const path& path, coord_t width, coord_t height, u32 fps);
+    /* the image must have the size the stream was opened with */
+    bool write(const image_view_t& image);
+    /* returns false if data couldn't be flushed */
+    bool close();
+
+    bool isOpen() const { return _file != nullptr; }
+  };
+}
@@ -2,9 +2,13 @@
 
 #include "ViewManager.h"
 #include "Common.h"
+#include "DemoScene.h"
+#include "FrameRecorder.h"
 
 struct ObjectGfx;
 
+namespace a3d { class SdlSink; }
+
 namespace ui
 {
   class MainView : public View
@@ -15,8 +19,23 @@ namespace ui
 
     bool keymap[256];
 
+    a3d::RenderTarget target;
+
+    /* only the interactive view needs a pool of its own, declared before the scene which uses it */
+    ThreadPool pool;
+    a3d::DemoScene scene;
+    a3d::SdlSink* sink;
+    a3d::FrameRecorder recorder;
+
+    /* rolling averages of the profiler stages in the top left corner */
+    void drawProfile();
+
+    /* frames are recorded to capture.y4m, dropped rather than slowing the loop down */
+    void toggleRecording();
+
   public:
     MainView(ViewManager* gvm);
+    ~MainView();
 
     void render() override;
     void handleKeyboardEvent(const SDL_Event& event) override;
@@ -0,0 +1,212 @@
+#pragma once
+
+#include "Common.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "glm/mat4x4.hpp"
+#include "glm/vec4.hpp"
+#include "glm/vec3.hpp"
+#include "glm/vec2.hpp"
+
+namespace math
+{
+  using real_t = float;
+
+  class vecz
+  {
+  public:
+    real_t x, y, z;
+
+    vecz() : vecz(0, 0, 0) { }
+    vecz(real_t x, real_t y, real_t z) : x(x), y(y), z(z) { }
+
+  public:
+    vecz operator+(const vecz& o) const { return vecz(x + o.x, y + o.y, z + o.z); }
+
+    inline real_t length() const { return std::sqrt(squaredLength()); }
+    inline real_t squaredLength() const { return x * x + y * y + z * z; }
+  };
+
+  class mat4
+  {
+  public:
+    float v[16];
+
+  public:
+
+  };
+}
+
+namespace a3d
+{
+  using vec2 = glm::vec2;
+
+  struct vec3 : public glm::vec3
+  {
+  public:
+    using glm::vec3::vec3;
+    vec3(const glm::vec3& v) : glm::vec3(v) { }
+
+    vec2 xy() const { return vec2(x, y); }
+  };
+
+  struct vec4 : public glm::vec4
+  {
+  public:
+    using glm::vec4::vec4;
+    vec4(const glm::vec4& v) : glm::vec4(v) { }
+
+    vec2 xy() const { return vec2(x, y); }
+    vec3 xyz() const { return vec3(x, y, z); }
+  };
+
+  struct mat4 : public glm::mat4
+  {
+  public:
+    using glm::mat4::mat4;
+    mat4(const glm::mat4& m) : glm::mat4(m) { }
+
+    mat4 inverse() { return glm::inverse(*this); }
+  };
+
+  /* axis aligned box and bounding sphere of a set of points, in the same space of the points */
+  struct Bounds
+  {
+    vec3 min, max;
+    vec3 center;
+    float radius;
+
+    static Bounds of(const vec3* points, size_t count)
+    {
+      Bounds bounds = { vec3(0.0f), vec3(0.0f), vec3(0.0f), 0.0f };
+
+      if (count == 0)
+        return bounds;
+
+      bounds.min = bounds.max = points[0];
+      for (size_t i = 1; i < count; ++i)
+      {
+        bounds.min = glm::min(bounds.min, points[i]);
+        bounds.max = glm::max(bounds.max, points[i]);
+      }
+
+      /* centered on the box, tighter than the half diagonal */
+      bounds.center = (bounds.min + bounds.max) * 0.5f;
+      for (size_t i = 0; i < count; ++i)
+        bounds.radius = std::max(bounds.radius, glm::length(points[i] - bounds.center));
+
+      return bounds;
+    }
+  };
+
+  /* the six planes of the view frustum extracted from a model-view-projection matrix, so they're expressed
+     in the model space of the object and its bounds can be tested as they are. A point p is inside
+     a plane when dot(plane.xyz, p) + plane.w >= 0 */
+  class Frustum
+  {
+  public:
+    enum class Test { OUTSIDE, INTERSECTING, INSIDE };
+
+  private:
+    std::array<glm::vec4, 6> _planes;
+
+  public:
+    Frustum(const mat4& mvp)
+    {
+      auto row = [&mvp](int i) { return glm::vec4(mvp[0][i], mvp[1][i], mvp[2][i], mvp[3][i]); };
+
+      _planes = { row(3) + row(0), row(3) - row(0), row(3) + row(1), row(3) - row(1), row(3) + row(2), row(3) - row(2) };
+
+      for (auto& plane : _planes)
+        plane /= glm::length(glm::vec3(plane.x, plane.y, plane.z));
+    }
+
+    /* the sphere is tried first since it's cheaper, the box only when the sphere crosses a plane */
+    Test test(const Bounds& bounds) const
+    {
+      bool crossing = false;
+
+      for (const auto& plane : _planes)
+      {
+        const float d = plane.x * bounds.center.x + plane.y * bounds.center.y + plane.z * bounds.center.z + plane.w;
+
+        if (d < -bounds.radius)
+          return Test::OUTSIDE;
+
+        crossing |= d < bounds.radius;
+      }
+
+      if (!crossing)
+        return Test::INSIDE;
+
+      crossing = false;
+
+      for (const auto& plane : _planes)
+      {
+        /* corners of the box farthest along the plane normal and farthest against it */
+        const vec3 p = vec3(plane.x >= 0 ? bounds.max.x : bounds.min.x, plane.y >= 0 ? bounds.max.y : bounds.min.y, plane.z >= 0 ? bounds.max.z : bounds.min.z);
+        const vec3 n = vec3(plane.x >= 0 ? bounds.min.x : bounds.max.x, plane.y >= 0 ? bounds.min.y : bounds.max.y, plane.z >= 0 ? bounds.min.z : bounds.max.z);
+
+        if (plane.x * p.x + plane.y * p.y + plane.z * p.z + plane.w < 0.0f)
+          return Test::OUTSIDE;
+
+        crossing |= plane.x * n.x + plane.y * n.y + plane.z * n.z + plane.w < 0.0f;
+      }
+
+      return crossing ? Test::INTERSECTING : Test::INSIDE;
+    }
+  };
+}
+
+namespace math
+{
+  class intersections
+  {
+  public:
+    static bool is2dPointInsideTriangle(a3d::vec2 p, a3d::vec2 p0, a3d::vec2 p1, a3d::vec2 p2)
+    {
+      float s = (p0.x - p2.x) * (p.y - p2.y) - (p0.y - p2.y) * (p.x - p2.x);
+      float t = (p1.x - p0.x) * (p.y - p0.y) - (p1.y - p0.y) * (p.x - p0.x);
+
+      if ((s < 0) != (t < 0) && s != 0 && t != 0)
+        return false;
+
+      float d = (p2.x - p1.x) * (p.y - p1.y) - (p2.y - p1.y) * (p.x - p1.x);
+      return d == 0 || (d < 0) == (s + t <= 0);
+    }
+  };
+
+  struct barycentric_coords
+  {
+    std::array<float, 3> lambdas;
+  };
+
+  class triangles
+  {
+  public:
+    static float edgeFunction(const a3d::vec2& a, const a3d::vec2& b, const a3d::vec2& c)
+    {
+      return (c.x - a.x) * (b.y - a.y) - (c.y - a.y) * (b.x - a.x);
+    }
+
+    static barycentric_coords barycentricCoords(const a3d::vec2& p, const a3d::vec2& v0, const a3d::vec2& v1, const a3d::vec2& v2)
+    {
+      float area = edgeFunction(v0, v1, v2);
+      float w0 = edgeFunction(v1, v2, p);
+      float w1 = edgeFunction(v2, v0, p);
+      float w2 = edgeFunction(v0, v1, p);
+
+      if (w0 >= 0 && w1 >= 0 && w2 >= 0)
+      {
+        w0 /= area;
+        w1 /= area;
+        w2 /= area;
+      }
+
+      return { {{w0, w1, w2}} };
+    }
+  };
+}
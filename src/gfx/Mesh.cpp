@@ -0,0 +1,119 @@
+#include "Mesh.h"
+
+#include <cstring>
+
+using namespace a3d;
+
+IndexBuffer::IndexBuffer(const u32* indices, size_t count, size_t vertexCount) : _count(count)
+{
+  _type = vertexCount <= size_t(UINT16_MAX) + 1 ? IndexType::U16 : IndexType::U32;
+  _data.resize(count * stride());
+
+  if (_type == IndexType::U16)
+  {
+    u16* data = reinterpret_cast<u16*>(_data.data());
+    for (size_t i = 0; i < count; ++i)
+      data[i] = u16(indices[i]);
+  }
+  else
+    std::memcpy(_data.data(), indices, count * sizeof(u32));
+}
+
+Mesh::Mesh(stream_t<vec3>&& positions, stream_t<vec3>&& normals, stream_t<vec2>&& textureCoords, IndexBuffer&& indices) :
+  _positions(std::move(positions)), _normals(std::move(normals)), _textureCoords(std::move(textureCoords)), _indices(std::move(indices))
+{
+  assert(_normals.size() == _positions.size() && _textureCoords.size() == _positions.size());
+  _bounds = Bounds::of(_positions.data(), _positions.size());
+}
+
+bool MeshBuilder::vertex_t::operator==(const vertex_t& o) const
+{
+  return std::memcmp(this, &o, sizeof(vertex_t)) == 0;
+}
+
+size_t MeshBuilder::vertex_t::hash::operator()(const vertex_t& v) const
+{
+  /* FNV-1a over the bit patterns, consistent with the bitwise comparison */
+  const u8* bytes = reinterpret_cast<const u8*>(&v);
+  u64 hash = 14695981039346656037ull;
+
+  for (size_t i = 0; i < sizeof(vertex_t); ++i)
+    hash = (hash ^ bytes[i]) * 1099511628211ull;
+
+  return size_t(hash);
+}
+
+u32 MeshBuilder::add(const vec3& position, const vec3& normal, const vec2& textureCoord)
+{
+  static_assert(sizeof(vertex_t) == sizeof(float) * 8, "vertex_t must not contain padding");
+
+  /* adding 0 turns -0 into +0 so that they're welded together */
+  vertex_t vertex = { position + vec3(0.0f), normal + vec3(0.0f), textureCoord + vec2(0.0f) };
+
+  auto it = _lookup.find(vertex);
+
+  if (it != _lookup.end())
+    return it->second;
+
+  const u32 index = u32(_positions.size());
+
+  _positions.push_back(vertex.position);
+  _normals.push_back(vertex.normal);
+  _textureCoords.push_back(vertex.textureCoord);
+  _lookup.emplace(vertex, index);
+
+  return index;
+}
+
+void MeshBuilder::computeNormals(const vec3* positions, size_t vertexCount, const u32* indices, size_t indexCount, vec3* normals)
+{
+  std::fill(normals, normals + vertexCount, vec3(0.0f));
+
+  for (size_t i = 0; i + 2 < indexCount; i += 3)
+  {
+    const vec3& p0 = positions[indices[i]];
+    const vec3& p1 = positions[indices[i + 1]];
+    const vec3& p2 = positions[indices[i + 2]];
+
+    /* the length of the cross product is twice the area of the triangle */
+    const vec3 normal = glm::cross(p1 - p0, p2 - p0);
+
+    for (size_t k = 0; k < 3; ++k)
+      normals[indices[i + k]] += normal;
+  }
+
+  for (size_t i = 0; i < vertexCount; ++i)
+  {
+    const float length = glm::length(normals[i]);
+    if (length > 0.0f)
+      normals[i] /= length;
+  }
+}
+
+Mesh MeshBuilder::build()
+{
+  IndexBuffer indices(_indices.data(), _indices.size(), _positions.size());
+  Mesh mesh(std::move(_positions), std::move(_normals), std::move(_textureCoords), std::move(indices));
+
+  _lookup.clear();
+  _positions.clear();
+  _normals.clear();
+  _textureCoords.clear();
+  _indices.clear();
+
+  return mesh;
+}
+
+Mesh MeshBuilder::fromSoup(const float* positions, size_t floatCount)
+{
+  MeshBuilder builder;
+
+  for (size_t i = 0; i + 8 < floatCount; i += 9)
+  {
+    const float* p = positions + i;
+    builder.triangle(builder.add(vec3(p[0], p[1], p[2])), builder.add(vec3(p[3], p[4], p[5])), builder.add(vec3(p[6], p[7], p[8])));
+  }
+
+  builder.computeNormals();
+  return builder.build();
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "Scene.h"
+#include "VertexProcessor.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace a3d
+{
+  /* vertex streams are aligned to the widest SIMD register we use */
+  template<typename T>
+  using stream_t = std::vector<T, aligned_allocator<T, 32>>;
+
+  using rasterize::IndexType;
+
+  /* triangle list indices stored as 16 bit values whenever every vertex can be addressed with them */
+  class IndexBuffer
+  {
+  private:
+    IndexType _type;
+    size_t _count;
+    stream_t<u8> _data;
+
+  public:
+    IndexBuffer() : _type(IndexType::U16), _count(0) { }
+    IndexBuffer(const u32* indices, size_t count, size_t vertexCount);
+
+    IndexType type() const { return _type; }
+    size_t count() const { return _count; }
+    size_t stride() const { return _type == IndexType::U16 ? sizeof(u16) : sizeof(u32); }
+
+    const void* data() const { return _data.data(); }
+    size_t sizeInBytes() const { return _data.size(); }
+
+    u32 operator[](size_t i) const
+    {
+      return _type == IndexType::U16 ? reinterpret_cast<const u16*>(_data.data())[i] : reinterpret_cast<const u32*>(_data.data())[i];
+    }
+  };
+
+  /* indexed triangle mesh, every attribute is stored in its own stream (structure of arrays) so that
+     the vertex stage reads only the ones it needs, all streams have the same length */
+  class Mesh : public Object
+  {
+  private:
+    stream_t<vec3> _positions;
+    stream_t<vec3> _normals;
+    stream_t<vec2> _textureCoords;
+    IndexBuffer _indices;
+
+    Bounds _bounds;
+
+  public:
+    Mesh() : _bounds(Bounds::of(nullptr, 0)) { }
+    Mesh(stream_t<vec3>&& positions, stream_t<vec3>&& normals, stream_t<vec2>&& textureCoords, IndexBuffer&& indices);
+
+    size_t vertexCount() const { return _positions.size(); }
+    size_t triangleCount() const { return _indices.count() / 3; }
+
+    const vec3* positions() const { return _positions.data(); }
+    const vec3* normals() const { return _normals.data(); }
+    const vec2* textureCoords() const { return _textureCoords.data(); }
+    const IndexBuffer& indices() const { return _indices; }
+
+    const Bounds& bounds() const { return _bounds; }
+
+    /* memory used by vertex and index data */
+    size_t sizeInBytes() const
+    {
+      return vertexCount() * (sizeof(vec3) + sizeof(vec3) + sizeof(vec2)) + _indices.sizeInBytes();
+    }
+
+    rasterize::IndexedGeometry geometry() const
+    {
+      return { positions(), textureCoords(), vertexCount(), _indices.data(), _indices.count(), &_bounds, _indices.type() };
+    }
+  };
+
+  /* accumulates vertices and triangles into a Mesh, vertices identical to one already added (all of
+     their attributes bit by bit) are welded together and reuse its index */
+  class MeshBuilder
+  {
+  private:
+    struct vertex_t
+    {
+      vec3 position;
+      vec3 normal;
+      vec2 textureCoord;
+
+      bool operator==(const vertex_t& o) const;
+
+      struct hash
+      {
+        size_t operator()(const vertex_t& v) const;
+      };
+    };
+
+    std::unordered_map<vertex_t, u32, vertex_t::hash> _lookup;
+
+    stream_t<vec3> _positions;
+    stream_t<vec3> _normals;
+    stream_t<vec2> _textureCoords;
+    std::vector<u32> _indices;
+
+  public:
+    /* returns the index of the vertex, reusing an existing one if identical */
+    u32 add(const vec3& position, const vec3& normal = vec3(0.0f), const vec2& textureCoord = vec2(0.0f));
+    void triangle(u32 i0, u32 i1, u32 i2) { _indices.insert(_indices.end(), { i0, i1, i2 }); }
+
+    /* smooth normals, average of the normals of the triangles sharing each vertex weighted by their area */
+    void computeNormals() { computeNormals(_positions.data(), _positions.size(), _indices.data(), _indices.size(), _normals.data()); }
+    static void computeNormals(const vec3* positions, size_t vertexCount, const u32* indices, size_t indexCount, vec3* normals);
+
+    size_t vertexCount() const { return _positions.size(); }
+
+    /* moves everything into the mesh, the builder is left empty */
+    Mesh build();
+
+    /* welds a flat list of x, y, z positions where every three vertices make a triangle, like Teapot.h,
+       normals are computed and texture coordinates left to zero */
+    static Mesh fromSoup(const float* positions, size_t floatCount);
+  };
+}
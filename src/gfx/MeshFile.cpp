@@ -0,0 +1,148 @@
+#include "MeshFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+using namespace a3d;
+
+namespace
+{
+  inline u64 align(u64 offset) { return (offset + MeshFile::ALIGNMENT - 1) & ~u64(MeshFile::ALIGNMENT - 1); }
+
+  template<typename I>
+  bool indicesInRange(const u8* data, u64 count, u64 vertexCount)
+  {
+    const I* indices = reinterpret_cast<const I*>(data);
+
+    /* the largest one is found first so that the loop has no early exit and vectorizes */
+    I largest = 0;
+    for (u64 i = 0; i < count; ++i)
+      largest = std::max(largest, indices[i]);
+
+    return count == 0 || largest < vertexCount;
+  }
+}
+
+bool MeshFile::write(const Mesh& mesh, const path& path)
+{
+  const auto& indices = mesh.indices();
+
+  header_t header;
+  std::memset(&header, 0, sizeof(header));
+
+  header.magic = MAGIC;
+  header.version = VERSION;
+  header.indexType = u32(indices.type());
+  header.vertexCount = mesh.vertexCount();
+  header.indexCount = indices.count();
+
+  header.positions = align(sizeof(header_t));
+  header.normals = align(header.positions + mesh.vertexCount() * sizeof(vec3));
+  header.textureCoords = align(header.normals + mesh.vertexCount() * sizeof(vec3));
+  header.indices = align(header.textureCoords + mesh.vertexCount() * sizeof(vec2));
+  header.fileSize = header.indices + indices.sizeInBytes();
+
+  const Bounds& bounds = mesh.bounds();
+  for (int i = 0; i < 3; ++i)
+  {
+    header.boundsMin[i] = bounds.min[i];
+    header.boundsMax[i] = bounds.max[i];
+    header.boundsCenter[i] = bounds.center[i];
+  }
+  header.boundsRadius = bounds.radius;
+
+  FILE* file = fopen(path.c_str(), "wb");
+
+  if (!file)
+    return false;
+
+  const struct { u64 offset; const void* data; size_t size; } blobs[] = {
+    { 0, &header, sizeof(header) },
+    { header.positions, mesh.positions(), mesh.vertexCount() * sizeof(vec3) },
+    { header.normals, mesh.normals(), mesh.vertexCount() * sizeof(vec3) },
+    { header.textureCoords, mesh.textureCoords(), mesh.vertexCount() * sizeof(vec2) },
+    { header.indices, indices.data(), indices.sizeInBytes() },
+  };
+
+  static const u8 padding[ALIGNMENT] = { 0 };
+  u64 position = 0;
+  bool success = true;
+
+  for (const auto& blob : blobs)
+  {
+    success &= fwrite(padding, 1, size_t(blob.offset - position), file) == blob.offset - position;
+    success &= blob.size == 0 || fwrite(blob.data, 1, blob.size, file) == blob.size;
+    position = blob.offset + blob.size;
+  }
+
+  success &= fclose(file) == 0;
+
+  return success;
+}
+
+const MeshFile::header_t* MeshFile::validate(const u8* data, size_t size)
+{
+  if (size < sizeof(header_t))
+    return nullptr;
+
+  const header_t* header = reinterpret_cast<const header_t*>(data);
+
+  if (header->magic != MAGIC || header->version != VERSION || header->fileSize != size)
+    return nullptr;
+
+  if (header->indexType != u32(IndexType::U16) && header->indexType != u32(IndexType::U32))
+    return nullptr;
+
+  const u64 stride = header->indexType == u32(IndexType::U16) ? sizeof(u16) : sizeof(u32);
+  const struct { u64 offset; u64 size; } streams[] = {
+    { header->positions, header->vertexCount * sizeof(vec3) },
+    { header->normals, header->vertexCount * sizeof(vec3) },
+    { header->textureCoords, header->vertexCount * sizeof(vec2) },
+    { header->indices, header->indexCount * stride },
+  };
+
+  /* counts are checked first so that the sizes above can't have overflowed */
+  if (header->vertexCount > size || header->indexCount > size)
+    return nullptr;
+
+  for (const auto& stream : streams)
+  {
+    if (stream.offset % ALIGNMENT != 0 || stream.offset < sizeof(header_t) || stream.offset > size || stream.size > size - stream.offset)
+      return nullptr;
+  }
+
+  /* the vertex stage trusts indices, a corrupt file would otherwise read past the mapped streams */
+  const u8* indices = data + header->indices;
+  if (header->indexType == u32(IndexType::U16) ? !indicesInRange<u16>(indices, header->indexCount, header->vertexCount) :
+    !indicesInRange<u32>(indices, header->indexCount, header->vertexCount))
+    return nullptr;
+
+  return header;
+}
+
+bool MappedMesh::open(const path& path)
+{
+  _header = nullptr;
+
+  if (!_file.open(path))
+    return false;
+
+  _header = MeshFile::validate(_file.data(), _file.size());
+
+  if (!_header)
+  {
+    _file.close();
+    return false;
+  }
+
+  for (int i = 0; i < 3; ++i)
+  {
+    _bounds.min[i] = _header->boundsMin[i];
+    _bounds.max[i] = _header->boundsMax[i];
+    _bounds.center[i] = _header->boundsCenter[i];
+  }
+  _bounds.radius = _header->boundsRadius;
+
+  return true;
+}
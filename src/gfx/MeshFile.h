@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Mesh.h"
+#include "MappedFile.h"
+
+namespace a3d
+{
+  /* binary mesh format meant to be mapped in memory and used in place, without parsing or copying.
+     A fixed header is followed by positions, normals, texture coordinates and indices, each stream
+     starts at an offset multiple of ALIGNMENT and is laid out exactly as in a Mesh. Values are
+     stored little endian, like every platform we build for */
+  class MeshFile
+  {
+  public:
+    static constexpr u32 MAGIC = 'A' | ('3' << 8) | ('D' << 16) | ('M' << 24);
+    static constexpr u32 VERSION = 1;
+    static constexpr size_t ALIGNMENT = 64;
+
+    struct header_t
+    {
+      u32 magic;
+      u32 version;
+      u32 indexType;
+      u32 reserved;
+
+      u64 vertexCount;
+      u64 indexCount;
+
+      /* offsets from the start of the file */
+      u64 positions;
+      u64 normals;
+      u64 textureCoords;
+      u64 indices;
+
+      u64 fileSize;
+
+      float boundsMin[3];
+      float boundsMax[3];
+      float boundsCenter[3];
+      float boundsRadius;
+    };
+
+    /* writes the mesh to path, returns false on I/O errors */
+    static bool write(const Mesh& mesh, const path& path);
+
+    /* returns the header if data (size bytes) is a well formed mesh file of the current version, with
+       every index referring to an existing vertex */
+    static const header_t* validate(const u8* data, size_t size);
+  };
+
+  /* mesh read from a MeshFile which is mapped in memory, its streams point straight into the mapping */
+  class MappedMesh : public Object
+  {
+  private:
+    MappedFile _file;
+    const MeshFile::header_t* _header;
+    Bounds _bounds;
+
+    template<typename T>
+    const T* stream(u64 offset) const { return reinterpret_cast<const T*>(_file.data() + offset); }
+
+  public:
+    MappedMesh() : _header(nullptr), _bounds(Bounds::of(nullptr, 0)) { }
+
+    /* returns false if the file can't be mapped or isn't a valid mesh file, indices are checked against
+       the vertex count so this touches every page of the index stream */
+    bool open(const path& path);
+    bool isOpen() const { return _header != nullptr; }
+
+    size_t vertexCount() const { return size_t(_header->vertexCount); }
+    size_t triangleCount() const { return size_t(_header->indexCount / 3); }
+
+    const vec3* positions() const { return stream<vec3>(_header->positions); }
+    const vec3* normals() const { return stream<vec3>(_header->normals); }
+    const vec2* textureCoords() const { return stream<vec2>(_header->textureCoords); }
+    const void* indices() const { return stream<u8>(_header->indices); }
+    IndexType indexType() const { return IndexType(_header->indexType); }
+
+    const Bounds& bounds() const { return _bounds; }
+
+    rasterize::IndexedGeometry geometry() const
+    {
+      return { positions(), textureCoords(), vertexCount(), indices(), size_t(_header->indexCount), &_bounds, indexType() };
+    }
+  };
+}
@@ -0,0 +1,504 @@
+#include "ObjImporter.h"
+
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+using namespace a3d;
+
+namespace
+{
+  constexpr int32_t NONE = INT32_MIN;
+  constexpr u32 MISSING = UINT32_MAX;
+
+  enum relative_t : u8
+  {
+    RELATIVE_V = 1 << 0,
+    RELATIVE_VT = 1 << 1,
+    RELATIVE_VN = 1 << 2
+  };
+
+  inline bool isSpace(char c) { return c == ' ' || c == '\t'; }
+  inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+  inline bool isEndOfLine(const char* p, const char* end) { return p == end || *p == '\n' || *p == '\r' || *p == '#'; }
+
+  inline const char* skipSpaces(const char* p, const char* end)
+  {
+    while (p != end && isSpace(*p))
+      ++p;
+    return p;
+  }
+
+  /* decimal float parser for the numbers found in OBJ files, not correctly rounded in every case but
+     much faster than strtof and independent from the locale. Returns nullptr if there's no number */
+  const char* parseFloat(const char* p, const char* end, float& value)
+  {
+    static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+    p = skipSpaces(p, end);
+
+    bool negative = false;
+    if (p != end && (*p == '-' || *p == '+'))
+      negative = *p++ == '-';
+
+    u64 mantissa = 0;
+    int32_t exponent = 0, digits = 0;
+    bool any = false;
+
+    for (; p != end && isDigit(*p); ++p, any = true)
+    {
+      if (digits < 18)
+      {
+        mantissa = mantissa * 10 + (*p - '0');
+        digits += mantissa != 0;
+      }
+      else
+        ++exponent;
+    }
+
+    if (p != end && *p == '.')
+    {
+      for (++p; p != end && isDigit(*p); ++p, any = true)
+      {
+        if (digits < 18)
+        {
+          mantissa = mantissa * 10 + (*p - '0');
+          digits += mantissa != 0;
+          --exponent;
+        }
+      }
+    }
+
+    if (!any)
+      return nullptr;
+
+    if (p != end && (*p == 'e' || *p == 'E'))
+    {
+      const char* e = p + 1;
+      bool negativeExponent = false;
+
+      if (e != end && (*e == '-' || *e == '+'))
+        negativeExponent = *e++ == '-';
+
+      if (e != end && isDigit(*e))
+      {
+        int32_t explicitExponent = 0;
+        for (; e != end && isDigit(*e); ++e)
+          explicitExponent = std::min(explicitExponent * 10 + (*e - '0'), 10000);
+
+        exponent += negativeExponent ? -explicitExponent : explicitExponent;
+        p = e;
+      }
+    }
+
+    double result = double(mantissa);
+
+    if (exponent >= 0)
+      result *= exponent <= 22 ? powers[exponent] : std::pow(10.0, exponent);
+    else
+      result /= -exponent <= 22 ? powers[-exponent] : std::pow(10.0, -exponent);
+
+    value = float(negative ? -result : result);
+    return p;
+  }
+
+  /* parses an index of a face corner, 0 is not a valid OBJ index so it's used for failure */
+  inline const char* parseIndex(const char* p, const char* end, int32_t& value)
+  {
+    bool negative = false;
+    if (p != end && *p == '-')
+    {
+      negative = true;
+      ++p;
+    }
+
+    int64_t result = 0;
+    const char* start = p;
+
+    for (; p != end && isDigit(*p); ++p)
+      result = std::min<int64_t>(result * 10 + (*p - '0'), INT32_MAX);
+
+    value = p == start ? 0 : int32_t(negative ? -result : result);
+    return p;
+  }
+
+  /* OBJ indices are 1 based and negative ones count backwards from the last element defined so far,
+     which can only be resolved against the chunk for now */
+  inline bool toIndex(int32_t index, size_t localCount, int32_t& result, u8& relative, u8 flag)
+  {
+    if (index > 0)
+      result = index - 1;
+    else if (index < 0)
+    {
+      result = int32_t(int64_t(localCount) + index);
+      relative |= flag;
+    }
+    else
+      return false;
+
+    return true;
+  }
+
+  /* open addressing table from (v, vt, vn) triplets to welded vertex indices */
+  class weld_table_t
+  {
+  private:
+    struct slot_t
+    {
+      u32 v, vt, vn;
+      u32 index;
+    };
+
+    std::vector<slot_t> _slots;
+    size_t _size;
+
+    static size_t hash(u32 v, u32 vt, u32 vn)
+    {
+      u64 h = (u64(v) * 0x9E3779B97F4A7C15ull) ^ (u64(vt) * 0xC2B2AE3D27D4EB4Full) ^ (u64(vn) * 0x165667B19E3779F9ull);
+      return size_t(h ^ (h >> 29));
+    }
+
+    void grow()
+    {
+      std::vector<slot_t> slots(_slots.size() * 2, slot_t{ 0, 0, 0, MISSING });
+      std::swap(slots, _slots);
+
+      const size_t mask = _slots.size() - 1;
+      for (const auto& slot : slots)
+      {
+        if (slot.index == MISSING)
+          continue;
+
+        size_t i = hash(slot.v, slot.vt, slot.vn) & mask;
+        while (_slots[i].index != MISSING)
+          i = (i + 1) & mask;
+        _slots[i] = slot;
+      }
+    }
+
+  public:
+    weld_table_t(size_t expected) : _size(0)
+    {
+      size_t capacity = 64;
+      while (capacity < expected * 2)
+        capacity *= 2;
+
+      _slots.resize(capacity, slot_t{ 0, 0, 0, MISSING });
+    }
+
+    /* returns the index of the triplet, inserting it with index candidate if it's not present */
+    u32 find(u32 v, u32 vt, u32 vn, u32 candidate)
+    {
+      if (_size * 2 >= _slots.size())
+        grow();
+
+      const size_t mask = _slots.size() - 1;
+      size_t i = hash(v, vt, vn) & mask;
+
+      while (_slots[i].index != MISSING)
+      {
+        const auto& slot = _slots[i];
+        if (slot.v == v && slot.vt == vt && slot.vn == vn)
+          return slot.index;
+        i = (i + 1) & mask;
+      }
+
+      _slots[i] = { v, vt, vn, candidate };
+      ++_size;
+      return candidate;
+    }
+  };
+}
+
+void ObjImporter::parseChunk(const char* p, const char* end, chunk_t& chunk)
+{
+  chunk.positions.clear();
+  chunk.textureCoords.clear();
+  chunk.normals.clear();
+  chunk.corners.clear();
+  chunk.relative.clear();
+  chunk.error.clear();
+  chunk.line = 0;
+
+  corner_t polygon[3];
+  u8 relative[3];
+
+  while (p != end)
+  {
+    const char* line = skipSpaces(p, end);
+    const char* next = line;
+
+    bool valid = true;
+
+    if (line != end && *line == 'v' && line + 1 != end)
+    {
+      float values[3] = { 0.0f, 0.0f, 0.0f };
+      const char* q = line + 1;
+
+      if (isSpace(*q))
+      {
+        for (size_t i = 0; i < 3 && valid; ++i)
+          valid = (q = parseFloat(q, end, values[i])) != nullptr;
+
+        if (valid)
+          chunk.positions.push_back(vec3(values[0], values[1], values[2]));
+      }
+      else if (*q == 't' && q + 1 != end && isSpace(q[1]))
+      {
+        ++q;
+        for (size_t i = 0; i < 2 && valid; ++i)
+          valid = (q = parseFloat(q, end, values[i])) != nullptr;
+
+        if (valid)
+          chunk.textureCoords.push_back(vec2(values[0], 1.0f - values[1]));
+      }
+      else if (*q == 'n' && q + 1 != end && isSpace(q[1]))
+      {
+        ++q;
+        for (size_t i = 0; i < 3 && valid; ++i)
+          valid = (q = parseFloat(q, end, values[i])) != nullptr;
+
+        if (valid)
+          chunk.normals.push_back(vec3(values[0], values[1], values[2]));
+      }
+
+      next = valid ? q : line;
+    }
+    else if (line != end && *line == 'f' && line + 1 != end && isSpace(line[1]))
+    {
+      const char* q = line + 1;
+      size_t count = 0;
+
+      while (valid)
+      {
+        q = skipSpaces(q, end);
+        if (isEndOfLine(q, end))
+          break;
+
+        int32_t v, vt = 0, vn = 0;
+        corner_t corner = { NONE, NONE, NONE };
+        u8 flags = 0;
+
+        q = parseIndex(q, end, v);
+        valid = toIndex(v, chunk.positions.size(), corner.v, flags, RELATIVE_V);
+
+        if (valid && q != end && *q == '/')
+        {
+          ++q;
+          if (q != end && *q != '/')
+          {
+            q = parseIndex(q, end, vt);
+            valid = toIndex(vt, chunk.textureCoords.size(), corner.vt, flags, RELATIVE_VT);
+          }
+
+          if (valid && q != end && *q == '/')
+          {
+            q = parseIndex(q + 1, end, vn);
+            valid = toIndex(vn, chunk.normals.size(), corner.vn, flags, RELATIVE_VN);
+          }
+        }
+
+        valid &= q == end || isSpace(*q) || isEndOfLine(q, end);
+
+        if (!valid)
+          break;
+
+        /* fan triangulation, the first corner is shared by every triangle of the polygon */
+        if (count < 3)
+        {
+          polygon[count] = corner;
+          relative[count] = flags;
+        }
+        else
+        {
+          polygon[1] = polygon[2];
+          relative[1] = relative[2];
+          polygon[2] = corner;
+          relative[2] = flags;
+        }
+
+        if (++count >= 3)
+        {
+          chunk.corners.insert(chunk.corners.end(), polygon, polygon + 3);
+          chunk.relative.insert(chunk.relative.end(), relative, relative + 3);
+        }
+      }
+
+      valid &= count >= 3;
+      next = q;
+    }
+
+    if (!valid)
+    {
+      chunk.error = "malformed statement";
+      return;
+    }
+
+    /* whatever follows on the line is ignored, as the statements we don't support */
+    while (next != end && *next != '\n')
+      ++next;
+
+    p = next != end ? next + 1 : end;
+    ++chunk.line;
+  }
+}
+
+bool ObjImporter::load(const path& path, Mesh& mesh)
+{
+  MappedFile file;
+
+  if (!file.open(path))
+  {
+    _error = "unable to open " + path;
+    return false;
+  }
+
+  return parse(reinterpret_cast<const char*>(file.data()), file.size(), mesh);
+}
+
+bool ObjImporter::parse(const char* data, size_t size, Mesh& mesh)
+{
+  _error.clear();
+
+  auto forEach = [this](size_t count, const std::function<void(size_t)>& function) {
+    if (_pool)
+      _pool->parallelFor(count, [&function](size_t index, size_t) { function(index); });
+    else
+    {
+      for (size_t i = 0; i < count; ++i)
+        function(i);
+    }
+  };
+
+  /* chunks end right after a new line so that no line is split between two of them */
+  std::vector<std::pair<size_t, size_t>> ranges;
+
+  for (size_t offset = 0; offset < size; )
+  {
+    size_t end = std::min(offset + CHUNK_SIZE, size);
+    while (end < size && data[end - 1] != '\n')
+      ++end;
+
+    ranges.emplace_back(offset, end);
+    offset = end;
+  }
+
+  _chunks.resize(ranges.size());
+  forEach(ranges.size(), [&](size_t i) { parseChunk(data + ranges[i].first, data + ranges[i].second, _chunks[i]); });
+
+  /* attributes defined before each chunk, needed to resolve its relative indices */
+  struct base_t { size_t v, vt, vn, corners; };
+  std::vector<base_t> bases(_chunks.size() + 1, base_t{ 0, 0, 0, 0 });
+  size_t line = 1;
+
+  for (size_t i = 0; i < _chunks.size(); ++i)
+  {
+    const auto& chunk = _chunks[i];
+
+    if (!chunk.error.empty())
+    {
+      _error = chunk.error + " at line " + std::to_string(line + chunk.line);
+      return false;
+    }
+
+    line += chunk.line;
+    bases[i + 1] = { bases[i].v + chunk.positions.size(), bases[i].vt + chunk.textureCoords.size(), bases[i].vn + chunk.normals.size(), bases[i].corners + chunk.corners.size() };
+  }
+
+  const base_t& total = bases.back();
+
+  if (total.v > UINT32_MAX || total.vt > UINT32_MAX || total.vn > UINT32_MAX || total.corners > UINT32_MAX)
+  {
+    _error = "too many elements";
+    return false;
+  }
+
+  std::vector<vec3> positions(total.v), normals(total.vn);
+  std::vector<vec2> textureCoords(total.vt);
+  std::vector<std::array<u32, 3>> corners(total.corners);
+  std::vector<u8> invalid(_chunks.size(), 0);
+  std::vector<u8> usesAttributes(_chunks.size(), 0);
+
+  forEach(_chunks.size(), [&](size_t i) {
+    const auto& chunk = _chunks[i];
+    const auto& base = bases[i];
+
+    std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + base.v);
+    std::copy(chunk.textureCoords.begin(), chunk.textureCoords.end(), textureCoords.begin() + base.vt);
+    std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + base.vn);
+
+    auto resolve = [&](int32_t index, bool relative, size_t base, size_t count, u32& result) {
+      if (index == NONE)
+        result = MISSING;
+      else
+      {
+        const int64_t global = relative ? int64_t(base) + index : int64_t(index);
+        invalid[i] |= global < 0 || global >= int64_t(count);
+        result = u32(global);
+      }
+    };
+
+    for (size_t c = 0; c < chunk.corners.size(); ++c)
+    {
+      const auto& corner = chunk.corners[c];
+      const u8 relative = chunk.relative[c];
+      auto& resolved = corners[base.corners + c];
+
+      resolve(corner.v, relative & RELATIVE_V, base.v, total.v, resolved[0]);
+      resolve(corner.vt, relative & RELATIVE_VT, base.vt, total.vt, resolved[1]);
+      resolve(corner.vn, relative & RELATIVE_VN, base.vn, total.vn, resolved[2]);
+
+      usesAttributes[i] |= resolved[1] != MISSING || resolved[2] != MISSING;
+    }
+  });
+
+  if (std::find(invalid.begin(), invalid.end(), 1) != invalid.end())
+  {
+    _error = "face index out of range";
+    return false;
+  }
+
+  stream_t<vec3> meshPositions, meshNormals;
+  stream_t<vec2> meshTextureCoords;
+  std::vector<u32> indices(corners.size());
+
+  /* without uvs and normals positions are already the vertices, nothing to weld */
+  if (std::find(usesAttributes.begin(), usesAttributes.end(), 1) == usesAttributes.end())
+  {
+    meshPositions.assign(positions.begin(), positions.end());
+    meshTextureCoords.resize(positions.size(), vec2(0.0f));
+    meshNormals.resize(positions.size());
+
+    for (size_t i = 0; i < corners.size(); ++i)
+      indices[i] = corners[i][0];
+  }
+  else
+  {
+    weld_table_t table(positions.size());
+
+    for (size_t i = 0; i < corners.size(); ++i)
+    {
+      const auto& corner = corners[i];
+      const u32 index = table.find(corner[0], corner[1], corner[2], u32(meshPositions.size()));
+
+      if (index == meshPositions.size())
+      {
+        meshPositions.push_back(positions[corner[0]]);
+        meshTextureCoords.push_back(corner[1] != MISSING ? textureCoords[corner[1]] : vec2(0.0f));
+        meshNormals.push_back(corner[2] != MISSING ? normals[corner[2]] : vec3(0.0f));
+      }
+
+      indices[i] = index;
+    }
+  }
+
+  if (normals.empty())
+    MeshBuilder::computeNormals(meshPositions.data(), meshPositions.size(), indices.data(), indices.size(), meshNormals.data());
+
+  IndexBuffer indexBuffer(indices.data(), indices.size(), meshPositions.size());
+  mesh = Mesh(std::move(meshPositions), std::move(meshNormals), std::move(meshTextureCoords), std::move(indexBuffer));
+
+  return true;
+}
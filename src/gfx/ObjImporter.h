@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Mesh.h"
+#include "ThreadPool.h"
+
+#include <string>
+#include <vector>
+
+namespace a3d
+{
+  /* Wavefront OBJ importer producing indexed meshes. The file is mapped and split in chunks at line
+     boundaries which are parsed in parallel on the pool, each into its own attribute and face lists;
+     relative indices are resolved once every chunk knows how many attributes came before it, then
+     face corners referencing the same position/uv/normal triplet are welded into a single vertex.
+
+     Only v, vt, vn and f statements are read, polygons are triangulated as fans. Texture coordinates
+     are flipped vertically since OBJ has v = 0 at the bottom of the image. Normals are computed when
+     the file has none */
+  class ObjImporter
+  {
+  public:
+    static constexpr size_t CHUNK_SIZE = 1 << 20;
+
+    struct corner_t
+    {
+      int32_t v, vt, vn;
+    };
+
+    struct chunk_t
+    {
+      std::vector<vec3> positions;
+      std::vector<vec2> textureCoords;
+      std::vector<vec3> normals;
+
+      /* three per triangle, indices are global and 0 based unless flagged as relative to the chunk */
+      std::vector<corner_t> corners;
+      std::vector<u8> relative;
+
+      size_t line;
+      std::string error;
+    };
+
+  private:
+    ThreadPool* _pool;
+
+    std::vector<chunk_t> _chunks;
+    std::string _error;
+
+    void parseChunk(const char* begin, const char* end, chunk_t& chunk);
+
+  public:
+    /* without a pool everything runs on the calling thread */
+    ObjImporter(ThreadPool* pool = nullptr) : _pool(pool) { }
+
+    /* returns false and sets error() if the file can't be read or is malformed */
+    bool load(const path& path, Mesh& mesh);
+    bool parse(const char* data, size_t size, Mesh& mesh);
+
+    const std::string& error() const { return _error; }
+  };
+}
@@ -0,0 +1,225 @@
+#include "OcclusionCuller.h"
+
+#if A3D_X86
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace a3d;
+using namespace a3d::rasterize;
+
+OcclusionCuller::OcclusionCuller(coord_t width, coord_t height) : _size({ width, height }), _pitch((width + 3) & ~3),
+  _depth(size_t(_pitch) * height), _frontFace(Winding::COUNTER_CLOCKWISE), _backFaceCulling(true), _stats()
+{
+  clear();
+}
+
+void OcclusionCuller::clear()
+{
+  std::fill(_depth.begin(), _depth.end(), std::numeric_limits<float>::max());
+}
+
+vec4 OcclusionCuller::project(const vec4& v) const
+{
+  const float invW = 1.0f / v.w;
+  return vec4((v.x * invW * 0.5f + 0.5f) * _size.w, (0.5f - v.y * invW * 0.5f) * _size.h, v.z * invW, v.w);
+}
+
+void OcclusionCuller::addOccluder(const mat4& mvp, const IndexedGeometry& geometry)
+{
+  ++_stats.occluders;
+
+  _screen.resize(geometry.vertexCount);
+
+  /* vertices in front of the near plane are marked with w = 0 and their triangles skipped */
+  for (size_t i = 0; i < geometry.vertexCount; ++i)
+  {
+    const vec4 clip = mvp * vec4(geometry.positions[i], 1.0f);
+    _screen[i] = clip.w > 0.0f && clip.z >= -clip.w ? project(clip) : vec4(0.0f);
+  }
+
+  const u16* indices16 = static_cast<const u16*>(geometry.indices);
+  const u32* indices32 = static_cast<const u32*>(geometry.indices);
+
+  for (size_t i = 0; i + 2 < geometry.indexCount; i += 3)
+  {
+    const vec4* v[3];
+
+    for (size_t k = 0; k < 3; ++k)
+      v[k] = &_screen[geometry.indexType == IndexType::U16 ? indices16[i + k] : indices32[i + k]];
+
+    if (v[0]->w == 0.0f || v[1]->w == 0.0f || v[2]->w == 0.0f)
+      continue;
+
+    /* same signed area and convention as VertexProcessor::isBackFacing */
+    float area = 0.0f;
+    for (size_t k = 0, j = 2; k < 3; j = k++)
+      area += v[j]->x * v[k]->y - v[k]->x * v[j]->y;
+
+    if (_backFaceCulling && (_frontFace == Winding::COUNTER_CLOCKWISE ? area >= 0.0f : area <= 0.0f))
+      continue;
+
+    rasterize(*v[0], *v[1], *v[2]);
+  }
+}
+
+void OcclusionCuller::rasterize(const vec4& v0, const vec4& v1, const vec4& v2)
+{
+  const vec4* v[3] = { &v0, &v1, &v2 };
+
+  /* only pixels entirely inside the triangle are written, so the bounding box shrinks to whole pixels */
+  const coord_t minX = std::max(coord_t(std::ceil(std::min({ v0.x, v1.x, v2.x }))), 0);
+  const coord_t minY = std::max(coord_t(std::ceil(std::min({ v0.y, v1.y, v2.y }))), 0);
+  const coord_t maxX = std::min(coord_t(std::floor(std::max({ v0.x, v1.x, v2.x }))) - 1, _size.w - 1);
+  const coord_t maxY = std::min(coord_t(std::floor(std::max({ v0.y, v1.y, v2.y }))) - 1, _size.h - 1);
+
+  if (minX > maxX || minY > maxY)
+    return;
+
+  /* edge k goes from vertex k to the next one, E(p) = a * x + b * y + c is positive inside once
+     oriented. A pixel is inside when E is at least the largest drop of E from its center to one of
+     its corners, plus the inset, which is folded into c */
+  const float cross = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+
+  if (cross == 0.0f)
+    return;
+
+  float a[3], b[3], c[3];
+  const float orientation = cross > 0.0f ? 1.0f : -1.0f;
+
+  for (size_t k = 0; k < 3; ++k)
+  {
+    const vec4& p = *v[k], &q = *v[(k + 1) % 3];
+
+    a[k] = (p.y - q.y) * orientation;
+    b[k] = (q.x - p.x) * orientation;
+    c[k] = (p.x * q.y - q.x * p.y) * orientation;
+
+    c[k] -= 0.5f * (std::abs(a[k]) + std::abs(b[k])) + COVERAGE_INSET * std::sqrt(a[k] * a[k] + b[k] * b[k]);
+  }
+
+  ++_stats.triangles;
+
+  /* the farthest depth of the triangle stands for all of it */
+  const float depth = std::max({ v0.z, v1.z, v2.z });
+  const coord_t startX = minX & ~3;
+
+#if A3D_X86
+  const __m128 lanes = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+  const __m128 zero = _mm_setzero_ps(), depths = _mm_set1_ps(depth);
+
+  __m128 stepX[3];
+  for (size_t k = 0; k < 3; ++k)
+    stepX[k] = _mm_set1_ps(4.0f * a[k]);
+
+  for (coord_t y = minY; y <= maxY; ++y)
+  {
+    float* row = _depth.data() + y * _pitch;
+    const float centerY = y + 0.5f;
+
+    __m128 e[3];
+    for (size_t k = 0; k < 3; ++k)
+      e[k] = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_set1_ps(float(startX)), lanes), _mm_set1_ps(a[k])), _mm_set1_ps(b[k] * centerY + c[k]));
+
+    for (coord_t x = startX; x <= maxX; x += 4)
+    {
+      const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e[0], zero), _mm_cmpge_ps(e[1], zero)), _mm_cmpge_ps(e[2], zero));
+
+      if (_mm_movemask_ps(inside))
+      {
+        const __m128 current = _mm_load_ps(row + x);
+        _mm_store_ps(row + x, _mm_or_ps(_mm_and_ps(inside, _mm_min_ps(current, depths)), _mm_andnot_ps(inside, current)));
+      }
+
+      for (size_t k = 0; k < 3; ++k)
+        e[k] = _mm_add_ps(e[k], stepX[k]);
+    }
+  }
+#else
+  for (coord_t y = minY; y <= maxY; ++y)
+  {
+    float* row = _depth.data() + y * _pitch;
+    const float centerY = y + 0.5f;
+
+    for (coord_t x = minX; x <= maxX; ++x)
+    {
+      const float centerX = x + 0.5f;
+
+      if (a[0] * centerX + b[0] * centerY + c[0] >= 0.0f && a[1] * centerX + b[1] * centerY + c[1] >= 0.0f && a[2] * centerX + b[2] * centerY + c[2] >= 0.0f)
+        row[x] = std::min(row[x], depth);
+    }
+  }
+#endif
+}
+
+bool OcclusionCuller::isAnyFarther(coord_t minX, coord_t minY, coord_t maxX, coord_t maxY, float depth) const
+{
+#if A3D_X86
+  const __m128i lanes = _mm_setr_epi32(0, 1, 2, 3);
+  const __m128i first = _mm_set1_epi32(minX - 1), last = _mm_set1_epi32(maxX + 1);
+  const __m128 depths = _mm_set1_ps(depth);
+
+  for (coord_t y = minY; y <= maxY; ++y)
+  {
+    const float* row = depthRow(y);
+
+    for (coord_t x = minX & ~3; x <= maxX; x += 4)
+    {
+      const __m128i index = _mm_add_epi32(_mm_set1_epi32(x), lanes);
+      const __m128i valid = _mm_and_si128(_mm_cmpgt_epi32(index, first), _mm_cmplt_epi32(index, last));
+      const __m128 farther = _mm_and_ps(_mm_cmpgt_ps(_mm_load_ps(row + x), depths), _mm_castsi128_ps(valid));
+
+      if (_mm_movemask_ps(farther))
+        return true;
+    }
+  }
+#else
+  for (coord_t y = minY; y <= maxY; ++y)
+  {
+    const float* row = depthRow(y);
+
+    for (coord_t x = minX; x <= maxX; ++x)
+      if (row[x] > depth)
+        return true;
+  }
+#endif
+
+  return false;
+}
+
+bool OcclusionCuller::isVisible(const mat4& mvp, const Bounds& bounds)
+{
+  ++_stats.tested;
+
+  float minX = std::numeric_limits<float>::max(), minY = minX, nearest = minX;
+  float maxX = -minX, maxY = -minX;
+
+  for (size_t i = 0; i < 8; ++i)
+  {
+    const vec3 corner = vec3(i & 1 ? bounds.max.x : bounds.min.x, i & 2 ? bounds.max.y : bounds.min.y, i & 4 ? bounds.max.z : bounds.min.z);
+    const vec4 clip = mvp * vec4(corner, 1.0f);
+
+    if (clip.w <= 0.0f || clip.z < -clip.w)
+      return true;
+
+    const vec4 p = project(clip);
+    minX = std::min(minX, p.x);
+    minY = std::min(minY, p.y);
+    maxX = std::max(maxX, p.x);
+    maxY = std::max(maxY, p.y);
+    nearest = std::min(nearest, p.z);
+  }
+
+  /* every pixel the box touches, grown by the inset. Boxes off the buffer are left to frustum culling */
+  const coord_t x0 = std::max(coord_t(std::floor(minX - COVERAGE_INSET)), 0), x1 = std::min(coord_t(std::floor(maxX + COVERAGE_INSET)), _size.w - 1);
+  const coord_t y0 = std::max(coord_t(std::floor(minY - COVERAGE_INSET)), 0), y1 = std::min(coord_t(std::floor(maxY + COVERAGE_INSET)), _size.h - 1);
+
+  if (x0 > x1 || y0 > y1 || isAnyFarther(x0, y0, x1, y1, nearest - DEPTH_MARGIN))
+    return true;
+
+  ++_stats.culled;
+  return false;
+}
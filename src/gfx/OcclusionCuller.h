@@ -0,0 +1,87 @@
+#pragma once
+
+#include "VertexProcessor.h"
+
+#include <vector>
+
+namespace a3d
+{
+  namespace rasterize
+  {
+    /* whole object visibility against a small depth buffer of its own, meant to run before objects are
+       handed to the vertex processor. Large objects marked as occluders are rasterized into it first,
+       then the bounding box of every other object is tested against it and objects entirely behind
+       what's there are skipped.
+
+       Everything errs on the side of visibility so that culling never changes the image: a pixel of the
+       buffer is only written when an occluder triangle covers it whole, inset by a fraction of a pixel,
+       and it takes the farthest depth of the triangle; boxes are tested with their nearest depth over
+       every pixel they touch. Triangles and boxes crossing the near plane are skipped and kept visible.
+       Occluder triangles the vertex processor would cull as back facing are skipped as well, so its
+       winding settings must be mirrored here.
+
+       Rows are padded to a multiple of 4 pixels and both passes work on 4 pixels at a time, with edge
+       functions evaluated for the whole group and coverage turned into a lane mask */
+    class OcclusionCuller
+    {
+    public:
+      /* how far inside a triangle (in pixels of the buffer) a pixel must be to count as covered, it
+         covers the snapping of vertices in the main rasterizer */
+      static constexpr float COVERAGE_INSET = 0.125f;
+
+      /* objects are culled only when they are farther than occluders by more than this, to cover the
+         error of interpolating depth in the main rasterizer */
+      static constexpr float DEPTH_MARGIN = 1.0f / (1 << 16);
+
+      struct Stats
+      {
+        u64 occluders;
+        u64 triangles;
+        u64 tested;
+        u64 culled;
+
+        void reset() { *this = Stats(); }
+      };
+
+    private:
+      size2d_t _size;
+      coord_t _pitch;
+
+      std::vector<float, aligned_allocator<float, 16>> _depth;
+
+      /* kept between occluders so that they don't allocate once grown to the largest one */
+      std::vector<vec4> _screen;
+
+      Winding _frontFace;
+      bool _backFaceCulling;
+
+      Stats _stats;
+
+      vec4 project(const vec4& clip) const;
+      void rasterize(const vec4& v0, const vec4& v1, const vec4& v2);
+      bool isAnyFarther(coord_t minX, coord_t minY, coord_t maxX, coord_t maxY, float depth) const;
+
+    public:
+      OcclusionCuller(coord_t width, coord_t height);
+
+      void setFrontFace(Winding winding) { _frontFace = winding; }
+      void setBackFaceCulling(bool enabled) { _backFaceCulling = enabled; }
+
+      /* empties the buffer, to be called every frame before adding occluders */
+      void clear();
+
+      /* mvp is the complete model-view-projection matrix of the object, as for VertexProcessor::draw */
+      void addOccluder(const mat4& mvp, const IndexedGeometry& geometry);
+
+      /* false only if the box, in object space, is hidden by the occluders added so far */
+      bool isVisible(const mat4& mvp, const Bounds& bounds);
+
+      const Stats& stats() const { return _stats; }
+      void resetStats() { _stats.reset(); }
+
+      coord_t width() const { return _size.w; }
+      coord_t height() const { return _size.h; }
+      const float* depthRow(coord_t y) const { return _depth.data() + y * _pitch; }
+    };
+  }
+}
@@ -0,0 +1,90 @@
+#include "PixelFormat.h"
+
+#include <cstring>
+
+using namespace a3d;
+
+namespace
+{
+  /* ARGB8888 is what SDL renderers stream without a conversion on every platform we run on. The
+     interactive view replaces it with the renderer's own format, headless runs with --format; it must
+     be changed before any texture or target is created since they capture it at construction */
+  PixelFormat declaredFormat = PixelFormat::ARGB8888;
+}
+
+void pixels::setFormat(PixelFormat format) { declaredFormat = format; }
+PixelFormat pixels::format() { return declaredFormat; }
+
+u32 pixels::sdlFormat(PixelFormat format)
+{
+  switch (format)
+  {
+  case PixelFormat::RGBA8888: return pixel_format_traits<PixelFormat::RGBA8888>::SDL_FORMAT;
+  default: return pixel_format_traits<PixelFormat::ARGB8888>::SDL_FORMAT;
+  }
+}
+
+bool pixels::fromSdlFormat(u32 sdlFormat, PixelFormat& format)
+{
+  for (PixelFormat candidate : { PixelFormat::ARGB8888, PixelFormat::RGBA8888 })
+  {
+    if (pixels::sdlFormat(candidate) == sdlFormat)
+    {
+      format = candidate;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+const char* pixels::name(PixelFormat format)
+{
+  switch (format)
+  {
+  case PixelFormat::ARGB8888: return "argb8888";
+  case PixelFormat::RGBA8888: return "rgba8888";
+  }
+
+  return "unknown";
+}
+
+bool pixels::fromName(const char* name, PixelFormat& format)
+{
+  for (PixelFormat candidate : { PixelFormat::ARGB8888, PixelFormat::RGBA8888 })
+  {
+    if (strcmp(pixels::name(candidate), name) == 0)
+    {
+      format = candidate;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+pixels::shifts_t pixels::shifts(PixelFormat format)
+{
+  using ARGB = pixel_format_traits<PixelFormat::ARGB8888>;
+  using RGBA = pixel_format_traits<PixelFormat::RGBA8888>;
+
+  if (format == PixelFormat::RGBA8888)
+    return { RGBA::R, RGBA::G, RGBA::B, RGBA::A };
+  else
+    return { ARGB::R, ARGB::G, ARGB::B, ARGB::A };
+}
+
+u32 pixels::pack(PixelFormat format, u8 r, u8 g, u8 b, u8 a)
+{
+  return format == PixelFormat::RGBA8888 ? packPixel<PixelFormat::RGBA8888>(r, g, b, a) : packPixel<PixelFormat::ARGB8888>(r, g, b, a);
+}
+
+void pixels::convert(PixelFormat from, PixelFormat to, const u32* source, u32* destination, size_t count)
+{
+  if (from == to)
+    std::memcpy(destination, source, count * sizeof(u32));
+  else if (from == PixelFormat::ARGB8888)
+    convertPixels<PixelFormat::ARGB8888, PixelFormat::RGBA8888>(source, destination, count);
+  else
+    convertPixels<PixelFormat::RGBA8888, PixelFormat::ARGB8888>(source, destination, count);
+}
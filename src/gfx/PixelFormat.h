@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Common.h"
+
+#include "SDL.h"
+
+namespace a3d
+{
+  /* packed 32 bit formats, named like the SDL ones from the most significant byte down. Textures and
+     render targets share the format declared at startup so that texels are converted once when they're
+     loaded and writing a fragment is a plain 32 bit copy */
+  enum class PixelFormat { ARGB8888, RGBA8888 };
+
+  template<PixelFormat F> struct pixel_format_traits;
+
+  template<> struct pixel_format_traits<PixelFormat::ARGB8888>
+  {
+    static constexpr u32 SDL_FORMAT = SDL_PIXELFORMAT_ARGB8888;
+    static constexpr u32 A = 24, R = 16, G = 8, B = 0;
+  };
+
+  template<> struct pixel_format_traits<PixelFormat::RGBA8888>
+  {
+    static constexpr u32 SDL_FORMAT = SDL_PIXELFORMAT_RGBA8888;
+    static constexpr u32 R = 24, G = 16, B = 8, A = 0;
+  };
+
+  template<PixelFormat F>
+  constexpr u32 packPixel(u8 r, u8 g, u8 b, u8 a)
+  {
+    using T = pixel_format_traits<F>;
+    return (u32(r) << T::R) | (u32(g) << T::G) | (u32(b) << T::B) | (u32(a) << T::A);
+  }
+
+  /* moves the channels of count pixels from format From to format To, a loop of shifts compilers vectorize */
+  template<PixelFormat From, PixelFormat To>
+  void convertPixels(const u32* source, u32* destination, size_t count)
+  {
+    using S = pixel_format_traits<From>;
+    using D = pixel_format_traits<To>;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+      const u32 p = source[i];
+      destination[i] = (((p >> S::R) & 0xFF) << D::R) | (((p >> S::G) & 0xFF) << D::G) | (((p >> S::B) & 0xFF) << D::B) | (((p >> S::A) & 0xFF) << D::A);
+    }
+  }
+
+  namespace pixels
+  {
+    /* format of textures and render targets created from now on, declared once at startup */
+    void setFormat(PixelFormat format);
+    PixelFormat format();
+
+    u32 sdlFormat(PixelFormat format);
+    /* returns false if the SDL format isn't one of ours */
+    bool fromSdlFormat(u32 sdlFormat, PixelFormat& format);
+    const char* name(PixelFormat format);
+    /* returns false if name isn't the name of one of ours */
+    bool fromName(const char* name, PixelFormat& format);
+
+    /* bit position of each channel, for code handling pixels whose format is only known at runtime */
+    struct shifts_t { u32 r, g, b, a; };
+    shifts_t shifts(PixelFormat format);
+
+    u32 pack(PixelFormat format, u8 r, u8 g, u8 b, u8 a);
+    /* copies count pixels converting them between formats, a memcpy when they're the same */
+    void convert(PixelFormat from, PixelFormat to, const u32* source, u32* destination, size_t count);
+  }
+}
@@ -0,0 +1,754 @@
+#include "Rasterizer.h"
+
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+
+using namespace a3d;
+using namespace a3d::rasterize;
+
+namespace
+{
+  /* floor division which rounds toward negative infinity also for negative numerators */
+  inline int64_t floorDiv(int64_t n, int64_t d)
+  {
+    return n >= 0 ? n / d : -((-n + d - 1) / d);
+  }
+
+  /* top-left fill rule: pixels exactly on an edge are owned only by left and top edges */
+  inline bool isTopLeft(int64_t a, int64_t b)
+  {
+    return a > 0 || (a == 0 && b > 0);
+  }
+
+  /* piecewise linear log2 from the bits of a float, exact on powers of two and below the true value in
+     between by at most 0.086 (at a mantissa of 1 / ln 2 - 1). The level of detail halves it, so trilinear
+     filtering blends levels with weights off by up to 0.043 */
+  inline float fastLog2(float value)
+  {
+    u32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return float(bits) * (1.0f / (1 << 23)) - 127.0f;
+  }
+
+  /* level of detail at a screen point from the derivatives of the texture coordinates (first two
+     varyings). Since u = (u/w) / (1/w) its derivative is du/dx = w * (d(u/w)/dx - u * d(1/w)/dx) */
+  inline float levelOfDetail(const TriangleSetup& setup, float x, float y, const vec2& textureSize)
+  {
+    const auto& invW = setup.invW;
+    const auto& pu = setup.varyings[0], &pv = setup.varyings[1];
+
+    const float w = 1.0f / invW.at(x, y);
+    const float u = pu.at(x, y) * w, v = pv.at(x, y) * w;
+
+    const float dudx = (pu.dx - u * invW.dx) * w * textureSize.x, dvdx = (pv.dx - v * invW.dx) * w * textureSize.y;
+    const float dudy = (pu.dy - u * invW.dy) * w * textureSize.x, dvdy = (pv.dy - v * invW.dy) * w * textureSize.y;
+
+    return 0.5f * fastLog2(std::max(dudx * dudx + dvdx * dvdx, dudy * dudy + dvdy * dvdy));
+  }
+
+  constexpr coord_t BLOCK_SHIFT = RenderTarget::DEPTH_BLOCK_SHIFT;
+  constexpr coord_t BLOCK_SIZE = RenderTarget::DEPTH_BLOCK_SIZE;
+  constexpr coord_t BLOCKS_PER_TILE = Rasterizer::TILE_SIZE / BLOCK_SIZE;
+
+  static_assert(Rasterizer::TILE_SIZE % BLOCK_SIZE == 0, "tiles must be made of whole depth blocks");
+
+  /* depth blocks overlapped by the part of a triangle inside a tile, at most BLOCKS_PER_TILE on each
+     side since tiles are aligned to blocks */
+  struct depth_blocks_t
+  {
+    coord_t x, y;
+    coord_t columns, rows;
+
+    /* bits of the row masks of the region falling in each column of blocks */
+    std::array<u32, BLOCKS_PER_TILE> columnMasks;
+
+    /* for each block the bounds of the triangle's depth over it and whether the region spans it whole */
+    std::array<float, BLOCKS_PER_TILE * BLOCKS_PER_TILE> low, high;
+    std::array<bool, BLOCKS_PER_TILE * BLOCKS_PER_TILE> spanned;
+
+    /* for each row of blocks the pixels written in any of its rows and in all of them */
+    std::array<u32, BLOCKS_PER_TILE> writtenAny, writtenAll;
+
+    void markWritten(coord_t row, u32 pixels)
+    {
+      const coord_t r = (row >> BLOCK_SHIFT) - y;
+      writtenAny[r] |= pixels;
+      writtenAll[r] &= pixels;
+    }
+  };
+
+  /* tests the triangle against the depth bounds of every block overlapped by the region. Since depth is
+     linear its extremes over a block are at the corner pixels, and can't exceed the vertices either.
+     Covered pixels of blocks whose farthest depth is nearer than the triangle are cleared from masks,
+     blocks whose nearest depth is farther have their pixels set in accepted, meaning that they pass
+     the depth test without reading it. Stale blocks are scanned again only when the triangle spans
+     them whole and their bounds as they are wouldn't reject it, since only then a scan can pay for
+     itself. Returns how many covered pixels were rejected */
+  u64 coarseDepthTest(const TriangleSetup& setup, RenderTarget& target, coord_t minX, coord_t minY, coord_t maxX, coord_t maxY,
+    u32* masks, u32* accepted, depth_blocks_t& blocks)
+  {
+    const auto& depth = setup.depth;
+    const float error = 2.0f * setup.depthError;
+    u64 rejected = 0;
+
+    blocks.x = minX >> BLOCK_SHIFT;
+    blocks.y = minY >> BLOCK_SHIFT;
+    blocks.columns = (maxX >> BLOCK_SHIFT) - blocks.x + 1;
+    blocks.rows = (maxY >> BLOCK_SHIFT) - blocks.y + 1;
+    blocks.writtenAny.fill(0);
+    blocks.writtenAll.fill(~0u);
+
+    for (coord_t c = 0; c < blocks.columns; ++c)
+    {
+      const coord_t x0 = std::max((blocks.x + c) << BLOCK_SHIFT, minX), x1 = std::min(((blocks.x + c) << BLOCK_SHIFT) + BLOCK_SIZE - 1, maxX);
+      blocks.columnMasks[c] = ((1u << (x1 - x0 + 1)) - 1) << (x0 - minX);
+    }
+
+    for (coord_t r = 0; r < blocks.rows; ++r)
+    {
+      const coord_t by = blocks.y + r;
+      const coord_t y0 = std::max(by << BLOCK_SHIFT, minY), y1 = std::min((by << BLOCK_SHIFT) + BLOCK_SIZE - 1, maxY);
+      const float* nearest = target.depthMinRow(by);
+      const float* farthest = target.depthMaxRow(by);
+
+      const float nearY = (depth.dy >= 0.0f ? y0 : y1) + 0.5f, farY = (depth.dy >= 0.0f ? y1 : y0) + 0.5f;
+      const coord_t blockY = by << BLOCK_SHIFT, blockHeight = std::min(blockY + BLOCK_SIZE, target.height()) - blockY;
+      const bool spansRows = y0 == blockY && y1 == blockY + blockHeight - 1;
+
+      for (coord_t c = 0; c < blocks.columns; ++c)
+      {
+        const coord_t bx = blocks.x + c;
+        const coord_t x0 = std::max(bx << BLOCK_SHIFT, minX), x1 = std::min((bx << BLOCK_SHIFT) + BLOCK_SIZE - 1, maxX);
+        const float nearX = (depth.dx >= 0.0f ? x0 : x1) + 0.5f, farX = (depth.dx >= 0.0f ? x1 : x0) + 0.5f;
+
+        const float low = std::max(depth.at(nearX, nearY), setup.depthMin) - error;
+        const float high = std::min(depth.at(farX, farY), setup.depthMax) + error;
+        const u32 columnMask = blocks.columnMasks[c];
+        const size_t index = r * BLOCKS_PER_TILE + c;
+
+        blocks.low[index] = low;
+        blocks.high[index] = high;
+        const coord_t blockX = bx << BLOCK_SHIFT, blockWidth = std::min(blockX + BLOCK_SIZE, target.width()) - blockX;
+        blocks.spanned[index] = spansRows && x0 == blockX && x1 == blockX + blockWidth - 1;
+
+        if (low < farthest[bx] && blocks.spanned[index] && target.depthStaleRow(by)[bx])
+          target.updateDepthBounds(bx, by);
+
+        if (low >= farthest[bx])
+        {
+          for (coord_t y = y0; y <= y1; ++y)
+          {
+            rejected += countBits(masks[y - minY] & columnMask);
+            masks[y - minY] &= ~columnMask;
+          }
+        }
+        else if (high < nearest[bx])
+        {
+          for (coord_t y = y0; y <= y1; ++y)
+            accepted[y - minY] |= columnMask;
+        }
+      }
+    }
+
+    return rejected;
+  }
+
+  /* widens the bounds of every block overlapped by the region to the depth range of the triangle */
+  void widenDepthBounds(RenderTarget& target, const TriangleSetup& setup, coord_t minX, coord_t minY, coord_t maxX, coord_t maxY)
+  {
+    const float error = 2.0f * setup.depthError;
+
+    for (coord_t by = minY >> BLOCK_SHIFT; by <= maxY >> BLOCK_SHIFT; ++by)
+      for (coord_t bx = minX >> BLOCK_SHIFT; bx <= maxX >> BLOCK_SHIFT; ++bx)
+        target.widenDepthBounds(bx, by, setup.depthMin - error, setup.depthMax + error);
+  }
+
+  /* keeps the bounds of the blocks which had depth written conservative. Blocks written entirely now hold
+     the triangle so they take its bounds, the others only widen theirs to include it: scanning them
+     again after every triangle would cost more than it saves when triangles are small */
+  void updateDepthBounds(RenderTarget& target, const depth_blocks_t& blocks)
+  {
+    for (coord_t r = 0; r < blocks.rows; ++r)
+    {
+      const coord_t by = blocks.y + r;
+
+      for (coord_t c = 0; c < blocks.columns; ++c)
+      {
+        const coord_t bx = blocks.x + c;
+        const size_t index = r * BLOCKS_PER_TILE + c;
+        const u32 mask = blocks.columnMasks[c];
+
+        if (!(blocks.writtenAny[r] & mask))
+          continue;
+        else if (blocks.spanned[index] && (blocks.writtenAll[r] & mask) == mask)
+          target.setDepthBounds(bx, by, blocks.low[index], blocks.high[index]);
+        else
+          target.widenDepthBounds(bx, by, blocks.low[index], blocks.high[index]);
+      }
+    }
+  }
+}
+
+void Rasterizer::setTarget(RenderTarget* target)
+{
+  _target = target;
+  _viewport = target->size();
+
+  size2d_t tiles = { (_viewport.w + TILE_SIZE - 1) >> TILE_SHIFT, (_viewport.h + TILE_SIZE - 1) >> TILE_SHIFT };
+
+  if (tiles.w != _tiles.w || tiles.h != _tiles.h)
+  {
+    _tiles = tiles;
+    _bins.clear();
+    _bins.resize(_tiles.w * _tiles.h);
+    _activeTiles.clear();
+    _setups.clear();
+  }
+}
+
+void Rasterizer::draw(const Triangle& triangle)
+{
+  ++_stats.triangles;
+
+  TriangleSetup setup;
+
+  if (!this->setup(triangle, setup))
+    return;
+
+  ++_stats.rasterized;
+
+  const u32 index = u32(_setups.size());
+  _setups.push_back(setup);
+
+  for (coord_t ty = setup.minY >> TILE_SHIFT; ty <= setup.maxY >> TILE_SHIFT; ++ty)
+  {
+    for (coord_t tx = setup.minX >> TILE_SHIFT; tx <= setup.maxX >> TILE_SHIFT; ++tx)
+    {
+      auto& bin = _bins[ty * _tiles.w + tx];
+
+      if (bin.empty())
+        _activeTiles.push_back(ty * _tiles.w + tx);
+
+      bin.push_back(index);
+      ++_stats.binned;
+    }
+  }
+}
+
+bool Rasterizer::setup(const Triangle& triangle, TriangleSetup& setup) const
+{
+  for (const auto& v : triangle.vertices)
+  {
+    /* written so that NaN coordinates are rejected too, vertices behind the eye can't be projected
+       so triangles crossing w = 0 must be clipped before getting here */
+    if (!(std::abs(v.x) < MAX_COORDINATE && std::abs(v.y) < MAX_COORDINATE && v.w > 0.0f))
+      return false;
+  }
+
+  std::array<size_t, 3> order = { 0, 1, 2 };
+  std::array<int64_t, 3> x, y;
+
+  for (size_t i = 0; i < 3; ++i)
+  {
+    x[i] = std::llround(triangle[i].x * SUBPIXEL_STEP);
+    y[i] = std::llround(triangle[i].y * SUBPIXEL_STEP);
+  }
+
+  int64_t area = (x[2] - x[0]) * (y[1] - y[0]) - (y[2] - y[0]) * (x[1] - x[0]);
+
+  if (area == 0)
+    return false;
+  /* both windings are accepted, counter clockwise triangles are flipped */
+  else if (area < 0)
+  {
+    std::swap(order[1], order[2]);
+    std::swap(x[1], x[2]);
+    std::swap(y[1], y[2]);
+    area = -area;
+  }
+
+  /* bounding box in pixels, a pixel is considered covered if its center is */
+  const int64_t half = SUBPIXEL_STEP / 2;
+  int64_t minX = floorDiv(*std::min_element(x.begin(), x.end()) - half + SUBPIXEL_STEP - 1, SUBPIXEL_STEP);
+  int64_t minY = floorDiv(*std::min_element(y.begin(), y.end()) - half + SUBPIXEL_STEP - 1, SUBPIXEL_STEP);
+  int64_t maxX = floorDiv(*std::max_element(x.begin(), x.end()) - half, SUBPIXEL_STEP);
+  int64_t maxY = floorDiv(*std::max_element(y.begin(), y.end()) - half, SUBPIXEL_STEP);
+
+  minX = std::max<int64_t>(minX, 0);
+  minY = std::max<int64_t>(minY, 0);
+  maxX = std::min<int64_t>(maxX, _viewport.w - 1);
+  maxY = std::min<int64_t>(maxY, _viewport.h - 1);
+
+  if (minX > maxX || minY > maxY)
+    return false;
+
+  /* edge i is the one opposite to vertex i so that E_i / area is its barycentric weight */
+  auto& e = setup.edges;
+
+  for (size_t i = 0; i < 3; ++i)
+  {
+    const size_t from = (i + 1) % 3, to = (i + 2) % 3;
+
+    e.a[i] = y[to] - y[from];
+    e.b[i] = -(x[to] - x[from]);
+    e.c[i] = -(e.a[i] * x[from] + e.b[i] * y[from]) + (isTopLeft(e.a[i], e.b[i]) ? 0 : -1);
+  }
+
+  setup.minX = coord_t(minX);
+  setup.minY = coord_t(minY);
+  setup.maxX = coord_t(maxX);
+  setup.maxY = coord_t(maxY);
+
+  /* with lambda_i = E_i(p) / area any attribute is f(p) = sum(f_i * E_i(p)) / area, which is linear in p,
+     so its gradient and its value at the origin are computed once here. Edge functions take sub-pixel
+     coordinates while planes are evaluated on pixel coordinates, hence the SUBPIXEL_STEP factor */
+  const double invArea = 1.0 / double(area);
+
+  auto plane = [&](const std::array<double, 3>& f) {
+    double dx = 0.0, dy = 0.0, c = 0.0;
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+      const size_t from = (i + 1) % 3;
+
+      dx += f[i] * e.a[i];
+      dy += f[i] * e.b[i];
+      /* without the fill rule bias which is meant only for coverage */
+      c -= f[i] * double(e.a[i] * x[from] + e.b[i] * y[from]);
+    }
+
+    return AttributePlane{ float(dx * SUBPIXEL_STEP * invArea), float(dy * SUBPIXEL_STEP * invArea), float(c * invArea) };
+  };
+
+  std::array<double, 3> invW;
+  for (size_t i = 0; i < 3; ++i)
+    invW[i] = 1.0 / triangle[order[i]].w;
+
+  setup.depth = plane({ triangle[order[0]].z, triangle[order[1]].z, triangle[order[2]].z });
+  setup.invW = plane(invW);
+
+  /* the depth of a pixel is the sum of three terms bounded by these, each operation rounds by at most
+     half an epsilon of the sum */
+  const auto& d = setup.depth;
+  setup.depthMin = std::min({ triangle[0].z, triangle[1].z, triangle[2].z });
+  setup.depthMax = std::max({ triangle[0].z, triangle[1].z, triangle[2].z });
+  setup.depthError = 4.0f * std::numeric_limits<float>::epsilon() *
+    (std::abs(d.c) + std::abs(d.dx) * _viewport.w + std::abs(d.dy) * _viewport.h + std::max(std::abs(setup.depthMin), std::abs(setup.depthMax)));
+
+  setup.varyingCount = triangle.varyingCount;
+  for (size_t v = 0; v < triangle.varyingCount; ++v)
+  {
+    const auto& f = triangle.varyings;
+    setup.varyings[v] = plane({ f[order[0]][v] * invW[0], f[order[1]][v] * invW[1], f[order[2]][v] * invW[2] });
+  }
+
+  /* texels are copied to the target as they are, without any swizzle */
+  assert(_texture->format() == _target->format());
+
+  setup.texture = _texture;
+  setup.mipFilter = _texture->levelCount() > 1 ? _mipFilter : MipFilter::NONE;
+  setup.filter = _filter;
+
+  return true;
+}
+
+void Rasterizer::flush()
+{
+  ProfileScope scope(Profiler::Stage::RASTERIZE);
+
+  const size_t workers = _pool ? _pool->size() : 1;
+
+  if (_workerStats.size() < workers)
+    _workerStats.resize(workers);
+
+  for (auto& stats : _workerStats)
+    stats.fragments = stats.rejected = stats.shaded = stats.coarseRejected = 0;
+
+  if (!_hierarchicalDepth)
+    _staleDepthBounds = true;
+  else if (_staleDepthBounds)
+  {
+    _target->updateDepthBounds();
+    _staleDepthBounds = false;
+  }
+
+  if (_shadingMode == ShadingMode::VISIBILITY && (_visibility.width() != size_t(_viewport.w) || _visibility.height() != size_t(_viewport.h)))
+    _visibility = Buffer2D<u32>(_viewport.w, _viewport.h);
+
+  if (_pool)
+    _pool->parallelFor(_activeTiles.size(), [this](size_t index, size_t worker) { rasterizeTile(_activeTiles[index], _workerStats[worker]); });
+  else
+  {
+    for (u32 tile : _activeTiles)
+      rasterizeTile(tile, _workerStats[0]);
+  }
+
+  for (const auto& stats : _workerStats)
+  {
+    _stats.fragments += stats.fragments;
+    _stats.rejected += stats.rejected;
+    _stats.coarseRejected += stats.coarseRejected;
+    _stats.shaded += stats.shaded;
+  }
+
+  for (u32 tile : _activeTiles)
+    _bins[tile].clear();
+
+  _activeTiles.clear();
+  _setups.clear();
+}
+
+void Rasterizer::rasterizeTile(size_t tile, worker_stats_t& stats)
+{
+  const coord_t tileX = coord_t(tile % _tiles.w) << TILE_SHIFT, tileY = coord_t(tile / _tiles.w) << TILE_SHIFT;
+
+  if (_shadingMode == ShadingMode::VISIBILITY)
+  {
+    const coord_t maxX = std::min(tileX + TILE_SIZE, _viewport.w) - 1, maxY = std::min(tileY + TILE_SIZE, _viewport.h) - 1;
+
+    /* the tile is only ever touched by the worker which rasterizes it, so it's cleared here */
+    for (coord_t y = tileY; y <= maxY; ++y)
+      std::fill(_visibility.row(y) + tileX, _visibility.row(y) + maxX + 1, 0);
+
+    for (u32 index : _bins[tile])
+    {
+      const auto& setup = _setups[index];
+
+      rasterizeVisibility(setup, index + 1,
+        std::max(setup.minX, tileX), std::max(setup.minY, tileY),
+        std::min(setup.maxX, maxX), std::min(setup.maxY, maxY),
+        stats
+      );
+    }
+
+    resolve(tileX, tileY, maxX, maxY, stats);
+    return;
+  }
+
+  for (u32 index : _bins[tile])
+  {
+    const auto& setup = _setups[index];
+
+    rasterize(setup,
+      std::max(setup.minX, tileX), std::max(setup.minY, tileY),
+      std::min(setup.maxX, tileX + TILE_SIZE - 1), std::min(setup.maxY, tileY + TILE_SIZE - 1),
+      stats
+    );
+  }
+}
+
+void Rasterizer::rasterize(const TriangleSetup& setup, coord_t minX, coord_t minY, coord_t maxX, coord_t maxY, worker_stats_t& stats)
+{
+  const coord_t width = maxX - minX + 1, height = maxY - minY + 1;
+  const auto& e = setup.edges;
+
+  /* coverage for the whole block first, one bit per pixel, then depth test and shading only on covered pixels */
+  u32 masks[TILE_SIZE];
+  auto kernel = coverage::fitsVectorRange(e, minX, minY, height) ? _coverage : &coverage::scalar;
+  kernel(e, minX, minY, width, height, masks);
+
+  /* regions smaller than a block skip the block test, which couldn't pay for itself there, and only
+     widen the bounds of the blocks they touch */
+  u32 accepted[TILE_SIZE] = { };
+  depth_blocks_t blocks;
+  const bool coarse = _hierarchicalDepth && width >= BLOCK_SIZE && height >= BLOCK_SIZE;
+  const u64 coarseRejected = coarse ? coarseDepthTest(setup, *_target, minX, minY, maxX, maxY, masks, accepted, blocks) : 0;
+
+  const Texture& texture = *setup.texture;
+  const auto& pu = setup.varyings[0], &pv = setup.varyings[1];
+  const float centerX = minX + 0.5f;
+
+  const bool mipmapped = setup.mipFilter != MipFilter::NONE;
+  const vec2 textureSize = vec2(texture.width(), texture.height());
+  coord_t quad = -1;
+  size_t level = 0;
+  u32 weight = 0;
+
+  /* fragments of a row which pass the depth test are collected and shaded together */
+  alignas(32) float us[TILE_SIZE], vs[TILE_SIZE];
+  alignas(32) u32 colors[TILE_SIZE];
+  u32 weights[TILE_SIZE];
+  u8 levels[TILE_SIZE], pixels[TILE_SIZE];
+
+  u64 fragments = coarseRejected, passed = 0;
+
+  for (coord_t r = 0; r < height; ++r)
+  {
+    u32 mask = masks[r];
+
+    if (!mask)
+    {
+      if (coarse)
+        blocks.markWritten(minY + r, 0);
+      continue;
+    }
+
+    const coord_t ty = minY + r;
+    const float centerY = ty + 0.5f;
+    /* rows entirely inside accepted blocks skip the comparisons */
+    const bool accept = (mask & ~accepted[r]) == 0;
+    u32 written = 0;
+
+    const float depthRow = setup.depth.at(centerX, centerY);
+    const float invWRow = setup.invW.at(centerX, centerY);
+    const float uRow = pu.at(centerX, centerY), vRow = pv.at(centerX, centerY);
+
+    float* depth = _target->depthRow(ty) + minX;
+    u32* color = _target->colorRow(ty) + minX;
+
+    size_t count = 0;
+    quad = -1;
+
+    do
+    {
+      const u32 i = countTrailingZeros(mask);
+      mask &= mask - 1;
+      ++fragments;
+
+      const float z = depthRow + setup.depth.dx * i;
+
+      if (accept || z < depth[i])
+      {
+        const float w = 1.0f / (invWRow + setup.invW.dx * i);
+
+        us[count] = (uRow + pu.dx * i) * w;
+        vs[count] = (vRow + pv.dx * i) * w;
+
+        if (mipmapped)
+        {
+          /* both rows of a quad compute the level of detail at its center so they agree on it */
+          const coord_t fragmentQuad = (minX + coord_t(i)) >> 1;
+
+          if (fragmentQuad != quad)
+          {
+            const float lod = levelOfDetail(setup, float((fragmentQuad << 1) + 1), float((ty & ~coord_t(1)) + 1), textureSize);
+            texture.selectLevel(lod, setup.mipFilter, level, weight);
+            quad = fragmentQuad;
+          }
+
+          levels[count] = u8(level);
+          weights[count] = weight;
+        }
+
+        pixels[count++] = u8(i);
+        depth[i] = z;
+        written |= 1u << i;
+      }
+    } while (mask);
+
+    if (coarse)
+      blocks.markWritten(ty, written);
+
+    shade(setup, us, vs, levels, weights, count, colors);
+
+    for (size_t k = 0; k < count; ++k)
+      color[pixels[k]] = colors[k];
+
+    passed += count;
+  }
+
+  if (coarse)
+    updateDepthBounds(*_target, blocks);
+  else if (_hierarchicalDepth && passed)
+    widenDepthBounds(*_target, setup, minX, minY, maxX, maxY);
+
+  stats.fragments += fragments;
+  stats.rejected += fragments - passed;
+  stats.coarseRejected += coarseRejected;
+  stats.shaded += passed;
+}
+
+void Rasterizer::rasterizeVisibility(const TriangleSetup& setup, u32 id, coord_t minX, coord_t minY, coord_t maxX, coord_t maxY, worker_stats_t& stats)
+{
+  const coord_t width = maxX - minX + 1, height = maxY - minY + 1;
+  const auto& e = setup.edges;
+
+  u32 masks[TILE_SIZE];
+  auto kernel = coverage::fitsVectorRange(e, minX, minY, height) ? _coverage : &coverage::scalar;
+  kernel(e, minX, minY, width, height, masks);
+
+  u32 accepted[TILE_SIZE] = { };
+  depth_blocks_t blocks;
+  const bool coarse = _hierarchicalDepth && width >= BLOCK_SIZE && height >= BLOCK_SIZE;
+  const u64 coarseRejected = coarse ? coarseDepthTest(setup, *_target, minX, minY, maxX, maxY, masks, accepted, blocks) : 0;
+
+  const float centerX = minX + 0.5f;
+  u64 fragments = coarseRejected, passed = 0;
+
+  for (coord_t r = 0; r < height; ++r)
+  {
+    u32 mask = masks[r];
+
+    if (!mask)
+    {
+      if (coarse)
+        blocks.markWritten(minY + r, 0);
+      continue;
+    }
+
+    const coord_t ty = minY + r;
+    const float depthRow = setup.depth.at(centerX, ty + 0.5f);
+
+    float* depth = _target->depthRow(ty) + minX;
+    u32* ids = _visibility.row(ty) + minX;
+    /* rows entirely inside accepted blocks skip the comparisons */
+    const bool accept = (mask & ~accepted[r]) == 0;
+    u32 written = 0;
+
+    do
+    {
+      const u32 i = countTrailingZeros(mask);
+      mask &= mask - 1;
+      ++fragments;
+
+      const float z = depthRow + setup.depth.dx * i;
+
+      if (accept || z < depth[i])
+      {
+        depth[i] = z;
+        ids[i] = id;
+        written |= 1u << i;
+        ++passed;
+      }
+    } while (mask);
+
+    if (coarse)
+      blocks.markWritten(ty, written);
+  }
+
+  if (coarse)
+    updateDepthBounds(*_target, blocks);
+  else if (_hierarchicalDepth && passed)
+    widenDepthBounds(*_target, setup, minX, minY, maxX, maxY);
+
+  stats.fragments += fragments;
+  stats.rejected += fragments - passed;
+  stats.coarseRejected += coarseRejected;
+}
+
+void Rasterizer::resolve(coord_t minX, coord_t minY, coord_t maxX, coord_t maxY, worker_stats_t& stats)
+{
+  alignas(32) float us[TILE_SIZE], vs[TILE_SIZE];
+  alignas(32) u32 colors[TILE_SIZE];
+  u32 weights[TILE_SIZE];
+  u8 levels[TILE_SIZE];
+
+  for (coord_t ty = minY; ty <= maxY; ++ty)
+  {
+    const u32* ids = _visibility.row(ty);
+    u32* color = _target->colorRow(ty);
+
+    /* pixels are shaded in runs covered by the same triangle. Attributes are evaluated from the planes
+       of the triangle stepping from the same origin the forward path uses, the left edge of the
+       triangle's bounding box inside the tile, so that both paths compute the same values */
+    for (coord_t x = minX; x <= maxX; )
+    {
+      const u32 id = ids[x];
+
+      if (!id)
+      {
+        ++x;
+        continue;
+      }
+
+      const TriangleSetup& setup = _setups[id - 1];
+      const Texture& texture = *setup.texture;
+      const auto& pu = setup.varyings[0], &pv = setup.varyings[1];
+      const bool mipmapped = setup.mipFilter != MipFilter::NONE;
+      const vec2 textureSize = vec2(texture.width(), texture.height());
+
+      const coord_t originX = std::max(setup.minX, minX);
+      const float centerX = originX + 0.5f, centerY = ty + 0.5f;
+      const float invWRow = setup.invW.at(centerX, centerY);
+      const float uRow = pu.at(centerX, centerY), vRow = pv.at(centerX, centerY);
+
+      coord_t quad = -1;
+      size_t level = 0;
+      u32 weight = 0;
+      size_t count = 0;
+      const coord_t begin = x;
+
+      for (; x <= maxX && ids[x] == id; ++x)
+      {
+        const u32 i = u32(x - originX);
+        const float w = 1.0f / (invWRow + setup.invW.dx * i);
+
+        us[count] = (uRow + pu.dx * i) * w;
+        vs[count] = (vRow + pv.dx * i) * w;
+
+        if (mipmapped)
+        {
+          const coord_t fragmentQuad = x >> 1;
+
+          if (fragmentQuad != quad)
+          {
+            const float lod = levelOfDetail(setup, float((fragmentQuad << 1) + 1), float((ty & ~coord_t(1)) + 1), textureSize);
+            texture.selectLevel(lod, setup.mipFilter, level, weight);
+            quad = fragmentQuad;
+          }
+
+          levels[count] = u8(level);
+          weights[count] = weight;
+        }
+
+        ++count;
+      }
+
+      shade(setup, us, vs, levels, weights, count, colors);
+      std::memcpy(color + begin, colors, count * sizeof(u32));
+
+      stats.shaded += count;
+    }
+  }
+}
+
+void Rasterizer::shade(const TriangleSetup& setup, const float* u, const float* v, const u8* levels, const u32* weights, size_t count, u32* colors) const
+{
+  const Texture& texture = *setup.texture;
+  const bool bilinear = setup.filter == TextureFilter::BILINEAR;
+
+  auto sample = [&](const Texture& level, size_t begin, size_t end, u32* output) {
+    if (bilinear)
+      _bilinear(level, u + begin, v + begin, end - begin, output + begin);
+    else
+    {
+      for (size_t k = begin; k < end; ++k)
+        output[k] = level.sample(vec2(u[k], v[k]));
+    }
+  };
+
+  if (setup.mipFilter == MipFilter::NONE)
+  {
+    sample(texture, 0, count, colors);
+    return;
+  }
+
+  /* fragments are sampled in runs which share the same level, inside a row that's usually all of them */
+  alignas(32) u32 next[TILE_SIZE];
+
+  for (size_t begin = 0; begin < count; )
+  {
+    const u8 level = levels[begin];
+    bool blend = false;
+    size_t end = begin;
+
+    for (; end < count && levels[end] == level; ++end)
+      blend |= weights[end] != 0;
+
+    sample(texture.level(level), begin, end, colors);
+
+    if (blend)
+    {
+      sample(texture.level(level + 1), begin, end, next);
+
+      for (size_t k = begin; k < end; ++k)
+        colors[k] = blendColors(colors[k], next[k], weights[k]);
+    }
+
+    begin = end;
+  }
+}
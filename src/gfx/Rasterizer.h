@@ -0,0 +1,263 @@
+#pragma once
+
+#include "Math.h"
+#include "Sampler.h"
+#include "RenderTarget.h"
+#include "Coverage.h"
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace a3d
+{
+  namespace rasterize
+  {
+    /* maximum amount of attributes interpolated across a triangle besides depth */
+    constexpr size_t MAX_VARYINGS = 8;
+
+    /* a triangle ready to be rasterized: x and y are in screen space, z is normalized device depth
+       and w is the clip space w, kept for perspective correct interpolation of the varyings */
+    class Triangle
+    {
+    public:
+      std::array<vec4, 3> vertices;
+      std::array<std::array<float, MAX_VARYINGS>, 3> varyings;
+      size_t varyingCount = 0;
+
+      const vec4& operator[](size_t i) const { return vertices[i]; }
+
+      /* stores a per vertex attribute (eg. vec2 texture coordinates) starting from varying slot offset */
+      template<typename T>
+      void setVarying(size_t offset, const std::array<T, 3>& values)
+      {
+        constexpr size_t length = size_t(T::length());
+        assert(offset + length <= MAX_VARYINGS);
+
+        for (size_t i = 0; i < 3; ++i)
+          for (size_t c = 0; c < length; ++c)
+            varyings[i][offset + c] = values[i][c];
+
+        varyingCount = std::max(varyingCount, offset + length);
+      }
+    };
+
+    /* an attribute expressed as a linear function of the pixel center, v(x, y) = c + dx * x + dy * y */
+    struct AttributePlane
+    {
+      float dx, dy, c;
+
+      float at(float x, float y) const { return c + dx * x + dy * y; }
+    };
+
+    /* FORWARD shades every fragment which passes the depth test as it's rasterized, so overdraw
+       multiplies shading. VISIBILITY rasterizes only depth and the triangle covering each pixel into a
+       visibility buffer, then shades every visible pixel once per tile from the attribute planes of its
+       triangle. Both produce the same image */
+    enum class ShadingMode { FORWARD, VISIBILITY };
+
+    struct Stats
+    {
+      u64 triangles;
+      u64 rasterized;
+      u64 binned;
+      /* covered pixels before the depth test, those which failed it and pixels whose color was computed */
+      u64 fragments;
+      u64 rejected;
+      u64 shaded;
+      /* part of rejected which was thrown away a depth block at a time, without per pixel tests */
+      u64 coarseRejected;
+
+      void reset() { *this = Stats(); }
+    };
+
+    /* everything the traversal needs to know about a triangle, computed once when it's submitted.
+       Edge functions are E(p) = a * p.x + b * p.y + c with p in fixed point, a pixel is covered
+       when all three are non negative */
+    struct TriangleSetup
+    {
+      EdgeEquations edges;
+      coord_t minX, minY, maxX, maxY;
+
+      /* depth is affine in screen space while varyings are interpolated as attr/w together with 1/w
+         and divided per pixel, so that each of them costs a multiply-add per fragment */
+      AttributePlane depth;
+      AttributePlane invW;
+      /* range of depth over the triangle and how far the float evaluation of the plane at a pixel can
+         stray from the exact value */
+      float depthMin, depthMax;
+      float depthError;
+      std::array<AttributePlane, MAX_VARYINGS> varyings;
+      size_t varyingCount;
+
+      const Texture* texture;
+      MipFilter mipFilter;
+      TextureFilter filter;
+    };
+
+    class Rasterizer
+    {
+    public:
+      /* triangles with vertices farther than this from the origin (in pixels) are discarded to
+         keep edge functions inside 64 bit range */
+      static constexpr float MAX_COORDINATE = float(1 << 24);
+
+      /* how far outside the viewport (in pixels) triangles can extend before they need to be clipped
+         against the screen edges, inside it traversal only visits the viewport part of the triangle anyway */
+      static constexpr float GUARD_BAND = float(1 << 14);
+
+      /* the screen is split in square tiles, triangles are binned into every tile their bounding box
+         overlaps and tiles are then rasterized independently */
+      static constexpr coord_t TILE_SHIFT = 5;
+      static constexpr coord_t TILE_SIZE = 1 << TILE_SHIFT;
+
+    private:
+      struct alignas(64) worker_stats_t
+      {
+        u64 fragments;
+        u64 rejected;
+        u64 shaded;
+        u64 coarseRejected;
+      };
+
+      size2d_t _viewport;
+
+      RenderTarget* _target;
+      const Texture* _texture;
+      MipFilter _mipFilter;
+      TextureFilter _filter;
+      ShadingMode _shadingMode;
+      bool _hierarchicalDepth;
+      /* set once depth has been written without keeping the block bounds of the target in sync */
+      bool _staleDepthBounds;
+      ThreadPool* _pool;
+
+      CoverageKernel _kernel;
+      coverage_function_t _coverage;
+
+      SamplerKernel _samplerKernel;
+      bilinear_function_t _bilinear;
+
+      size2d_t _tiles;
+      std::vector<TriangleSetup> _setups;
+      std::vector<std::vector<u32>> _bins;
+      std::vector<u32> _activeTiles;
+      std::vector<worker_stats_t> _workerStats;
+
+      /* index + 1 of the triangle visible at each pixel in the current flush, 0 where none is */
+      Buffer2D<u32> _visibility;
+
+      Stats _stats;
+
+      void rasterizeTile(size_t tile, worker_stats_t& stats);
+      void rasterize(const TriangleSetup& setup, coord_t minX, coord_t minY, coord_t maxX, coord_t maxY, worker_stats_t& stats);
+      void rasterizeVisibility(const TriangleSetup& setup, u32 id, coord_t minX, coord_t minY, coord_t maxX, coord_t maxY, worker_stats_t& stats);
+      /* shades the pixels of a tile left in the visibility buffer */
+      void resolve(coord_t minX, coord_t minY, coord_t maxX, coord_t maxY, worker_stats_t& stats);
+
+      /* colors of count fragments at texture coordinates (u, v), with the level and the weight of the
+         following one selected for each fragment when the triangle is mipmapped */
+      void shade(const TriangleSetup& setup, const float* u, const float* v, const u8* levels, const u32* weights, size_t count, u32* colors) const;
+
+    public:
+      Rasterizer() : _viewport({ 0, 0 }), _target(nullptr), _texture(nullptr), _mipFilter(MipFilter::NONE), _filter(TextureFilter::NEAREST),
+        _shadingMode(ShadingMode::FORWARD), _hierarchicalDepth(true), _staleDepthBounds(false), _pool(nullptr), _tiles({ 0, 0 }), _visibility(0, 0), _stats()
+      {
+        setCoverageKernel(coverage::best());
+        setSamplerKernel(sampler::best());
+      }
+
+      /* the viewport always covers the whole target */
+      void setTarget(RenderTarget* target);
+      const size2d_t& viewport() const { return _viewport; }
+
+      void setTexture(const Texture* texture) { _texture = texture; }
+
+      /* how the mip chain of the texture is sampled, the level of detail is computed once per 2x2 quad
+         of pixels from the derivatives of the texture coordinates. Textures without mipmaps always
+         sample their base level */
+      void setMipFilter(MipFilter filter) { _mipFilter = filter; }
+      MipFilter mipFilter() const { return _mipFilter; }
+
+      /* filtering inside a level of the texture for the following draws */
+      void setTextureFilter(TextureFilter filter) { _filter = filter; }
+      TextureFilter textureFilter() const { return _filter; }
+
+      /* when fragments are shaded, takes effect from the next flush */
+      void setShadingMode(ShadingMode mode) { _shadingMode = mode; }
+      ShadingMode shadingMode() const { return _shadingMode; }
+
+      /* when enabled the depth blocks of the target overlapped by a triangle are tested first: blocks
+         entirely nearer than the triangle are rejected without touching their pixels, blocks entirely
+         farther let every covered pixel through without reading its depth */
+      void setHierarchicalDepth(bool enabled) { _hierarchicalDepth = enabled; }
+      bool hierarchicalDepth() const { return _hierarchicalDepth; }
+
+      /* selects the kernel used for bilinear filtering, returns false if the cpu doesn't support it */
+      bool setSamplerKernel(SamplerKernel kernel)
+      {
+        if (!sampler::isSupported(kernel))
+          return false;
+
+        _samplerKernel = kernel;
+        _bilinear = sampler::function(kernel);
+        return true;
+      }
+      SamplerKernel samplerKernel() const { return _samplerKernel; }
+
+      /* tiles are rasterized on the pool if present, on the calling thread otherwise,
+         the output is the same in both cases */
+      void setThreadPool(ThreadPool* pool) { _pool = pool; }
+
+      /* selects the kernel used to compute pixel coverage, returns false if the cpu doesn't support it */
+      bool setCoverageKernel(CoverageKernel kernel)
+      {
+        if (!coverage::isSupported(kernel))
+          return false;
+
+        _kernel = kernel;
+        _coverage = coverage::function(kernel);
+        return true;
+      }
+      CoverageKernel coverageKernel() const { return _kernel; }
+
+      const Stats& stats() const { return _stats; }
+      void resetStats() { _stats.reset(); }
+
+      /* extent of the guard band in normalized device coordinates, along x and y */
+      vec2 guardBand() const { return vec2(1.0f + 2.0f * GUARD_BAND / _viewport.w, 1.0f + 2.0f * GUARD_BAND / _viewport.h); }
+
+      /* maps a vertex in clip space to the viewport, y grows downwards on screen, z becomes normalized
+         device depth and w is kept as it is */
+      vec4 project(const vec4& v) const
+      {
+        const float invW = 1.0f / v.w;
+        return vec4((v.x * invW * 0.5f + 0.5f) * _viewport.w, (0.5f - v.y * invW * 0.5f) * _viewport.h, v.z * invW, v.w);
+      }
+
+      Triangle projectRectangle(const std::array<vec4, 3>& vertices)
+      {
+        Triangle triangle;
+
+        for (size_t i = 0; i < vertices.size(); ++i)
+          triangle.vertices[i] = project(vertices[i]);
+
+        return triangle;
+      }
+
+      /* queues a screen space triangle as returned by projectRectangle for rasterization with the
+         current texture, which is sampled with the first two varyings. Fragments pass the depth test
+         when they're closer than what's in the target, that is when their depth is smaller */
+      void draw(const Triangle& triangle);
+
+      /* computes the setup of a triangle for the current viewport and texture, returns false if it
+         doesn't cover any pixel */
+      bool setup(const Triangle& triangle, TriangleSetup& setup) const;
+
+      /* rasterizes every queued triangle into the current target, triangles are drawn in
+         submission order inside each tile */
+      void flush();
+    };
+  }
+}
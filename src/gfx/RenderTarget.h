@@ -0,0 +1,133 @@
+#pragma once
+
+#include "Texture.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace a3d
+{
+  /* color and depth planes the rasterizer draws into. The depth plane is owned and allocated once,
+     the color plane is bound every frame to memory owned by someone else (eg. a locked streaming
+     texture) so that the rasterizer writes straight to its final destination. The color plane holds
+     pixels in format(), textures drawn into it must have been loaded in the same format.
+
+     Next to the depth plane the nearest and farthest depth of each DEPTH_BLOCK_SIZE square block are
+     kept, so that the rasterizer can test a whole block against a triangle at once. Bounds are always
+     conservative but can be stale, ie. wider than the depth they hold, until they're scanned again.
+     The rasterizer keeps them up to date, anyone else writing depth must call updateDepthBounds() */
+  class RenderTarget
+  {
+  public:
+    static constexpr coord_t DEPTH_BLOCK_SHIFT = 3;
+    static constexpr coord_t DEPTH_BLOCK_SIZE = 1 << DEPTH_BLOCK_SHIFT;
+
+  private:
+    size2d_t _size;
+    PixelFormat _format;
+
+    Buffer2D<float> _depth;
+    Buffer2D<float> _depthMin;
+    Buffer2D<float> _depthMax;
+    Buffer2D<u8> _depthStale;
+
+    u32* _color;
+    size_t _pitch;
+
+  public:
+    RenderTarget(coord_t width, coord_t height, PixelFormat format = pixels::format()) :
+      _size({ width, height }), _format(format), _depth(width, height),
+      _depthMin((width + DEPTH_BLOCK_SIZE - 1) >> DEPTH_BLOCK_SHIFT, (height + DEPTH_BLOCK_SIZE - 1) >> DEPTH_BLOCK_SHIFT),
+      _depthMax(_depthMin.width(), _depthMin.height()), _depthStale(_depthMin.width(), _depthMin.height()), _color(nullptr), _pitch(0) { }
+
+    /* pitch is expressed in pixels, not bytes */
+    void bindColor(u32* pixels, size_t pitch) { _color = pixels; _pitch = pitch; }
+    void unbindColor() { _color = nullptr; _pitch = 0; }
+    bool hasColor() const { return _color != nullptr; }
+
+    void clear(u32 color, float depth)
+    {
+      if (_color)
+      {
+        for (coord_t y = 0; y < _size.h; ++y)
+        {
+          if (color == 0)
+            std::memset(colorRow(y), 0, _size.w * sizeof(u32));
+          else
+            std::fill(colorRow(y), colorRow(y) + _size.w, color);
+        }
+      }
+
+      std::fill(_depth.data(), _depth.data() + _size.w * _size.h, depth);
+      std::fill(_depthMin.data(), _depthMin.data() + _depthMin.width() * _depthMin.height(), depth);
+      std::fill(_depthMax.data(), _depthMax.data() + _depthMax.width() * _depthMax.height(), depth);
+      std::fill(_depthStale.data(), _depthStale.data() + _depthStale.width() * _depthStale.height(), 0);
+    }
+
+    /* recomputes the bounds of block (bx, by) from the depth plane */
+    void updateDepthBounds(coord_t bx, coord_t by)
+    {
+      const coord_t x0 = bx << DEPTH_BLOCK_SHIFT, y0 = by << DEPTH_BLOCK_SHIFT;
+      const coord_t x1 = std::min(x0 + DEPTH_BLOCK_SIZE, _size.w), y1 = std::min(y0 + DEPTH_BLOCK_SIZE, _size.h);
+      float nearest = _depth.row(y0)[x0], farthest = nearest;
+
+      for (coord_t y = y0; y < y1; ++y)
+      {
+        const float* depth = _depth.row(y);
+
+        for (coord_t x = x0; x < x1; ++x)
+        {
+          nearest = std::min(nearest, depth[x]);
+          farthest = std::max(farthest, depth[x]);
+        }
+      }
+
+      _depthMin.row(by)[bx] = nearest;
+      _depthMax.row(by)[bx] = farthest;
+      _depthStale.row(by)[bx] = 0;
+    }
+
+    /* sets the bounds of block (bx, by) to ones known to hold its depth, eg. when it was just filled by a plane */
+    void setDepthBounds(coord_t bx, coord_t by, float nearest, float farthest)
+    {
+      _depthMin.row(by)[bx] = nearest;
+      _depthMax.row(by)[bx] = farthest;
+      _depthStale.row(by)[bx] = 0;
+    }
+
+    /* extends the bounds of block (bx, by) to a range of depth written into part of it, which leaves
+       them stale since the farthest depth could have been overwritten */
+    void widenDepthBounds(coord_t bx, coord_t by, float nearest, float farthest)
+    {
+      _depthMin.row(by)[bx] = std::min(_depthMin.row(by)[bx], nearest);
+      _depthMax.row(by)[bx] = std::max(_depthMax.row(by)[bx], farthest);
+      _depthStale.row(by)[bx] = 1;
+    }
+
+    void updateDepthBounds()
+    {
+      for (coord_t by = 0; by < coord_t(_depthMin.height()); ++by)
+        for (coord_t bx = 0; bx < coord_t(_depthMin.width()); ++bx)
+          updateDepthBounds(bx, by);
+    }
+
+    u32* colorRow(size_t y) { return _color + y * _pitch; }
+    const u32* colorRow(size_t y) const { return _color + y * _pitch; }
+    float* depthRow(size_t y) { return _depth.row(y); }
+    const float* depthRow(size_t y) const { return _depth.row(y); }
+
+    Buffer2D<float>& depth() { return _depth; }
+
+    /* rows of the per block bounds, indexed by block */
+    const float* depthMinRow(size_t by) const { return _depthMin.row(by); }
+    const float* depthMaxRow(size_t by) const { return _depthMax.row(by); }
+    const u8* depthStaleRow(size_t by) const { return _depthStale.row(by); }
+    size_t pitch() const { return _pitch; }
+
+    PixelFormat format() const { return _format; }
+
+    coord_t width() const { return _size.w; }
+    coord_t height() const { return _size.h; }
+    const size2d_t& size() const { return _size; }
+  };
+}
@@ -0,0 +1,159 @@
+#include "Sampler.h"
+
+#include "SDL.h"
+
+#if A3D_X86
+#include <emmintrin.h>
+#endif
+
+using namespace a3d;
+
+void sampler::scalar(const Texture& texture, const float* u, const float* v, size_t count, u32* colors)
+{
+  for (size_t i = 0; i < count; ++i)
+  {
+    colors[i] = texture.sampleBilinear(vec2(u[i], v[i]));
+  }
+}
+
+#if A3D_X86
+namespace
+{
+  /* SSE2 has no 32 bit min and max, both are built from a compare */
+  inline __m128i clamp(__m128i value, __m128i max)
+  {
+    value = _mm_and_si128(value, _mm_cmpgt_epi32(value, _mm_set1_epi32(-1)));
+    const __m128i over = _mm_cmpgt_epi32(value, max);
+    return _mm_or_si128(_mm_and_si128(over, max), _mm_andnot_si128(over, value));
+  }
+
+  /* weight of each fragment repeated over the four channels of its texel, for fragments 0-1 and 2-3 */
+  inline void expandWeights(__m128i weights, __m128i& low, __m128i& high)
+  {
+    const __m128i packed = _mm_packs_epi32(weights, weights);
+    const __m128i pairs = _mm_unpacklo_epi16(packed, packed);
+    low = _mm_unpacklo_epi32(pairs, pairs);
+    high = _mm_unpackhi_epi32(pairs, pairs);
+  }
+}
+
+void sampler::sse2(const Texture& texture, const float* u, const float* v, size_t count, u32* colors)
+{
+  const u32* texels = texture.texels();
+  const u32* columns = texture.columnOffsets();
+  const u32* rows = texture.rowOffsets();
+
+  const __m128 scaleX = _mm_set1_ps(texture.width() * 256.0f), scaleY = _mm_set1_ps(texture.height() * 256.0f);
+  const __m128 bias = _mm_set1_ps(float(Texture::BILINEAR_BIAS * 256 - 128));
+  const __m128i unbias = _mm_set1_epi32(Texture::BILINEAR_BIAS * 256);
+  const __m128i maxX = _mm_set1_epi32(int32_t(texture.width()) - 1), maxY = _mm_set1_epi32(int32_t(texture.height()) - 1);
+  const __m128i one = _mm_set1_epi32(1), fraction = _mm_set1_epi32(0xFF), full = _mm_set1_epi32(256), half = _mm_set1_epi32(128);
+  const __m128i zero = _mm_setzero_si128(), round = _mm_set1_epi16(128);
+
+  size_t i = 0;
+
+  for (; i + 4 <= count; i += 4)
+  {
+    const __m128i x = _mm_sub_epi32(_mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(u + i), scaleX), bias)), unbias);
+    const __m128i y = _mm_sub_epi32(_mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(v + i), scaleY), bias)), unbias);
+
+    const __m128i fx = _mm_and_si128(x, fraction), fy = _mm_and_si128(y, fraction);
+    const __m128i x0 = _mm_srai_epi32(x, 8), y0 = _mm_srai_epi32(y, 8);
+
+    alignas(16) u32 cx[2][4], cy[2][4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(cx[0]), clamp(x0, maxX));
+    _mm_store_si128(reinterpret_cast<__m128i*>(cx[1]), clamp(_mm_add_epi32(x0, one), maxX));
+    _mm_store_si128(reinterpret_cast<__m128i*>(cy[0]), clamp(y0, maxY));
+    _mm_store_si128(reinterpret_cast<__m128i*>(cy[1]), clamp(_mm_add_epi32(y0, one), maxY));
+
+    alignas(16) u32 t[4][4];
+    for (size_t k = 0; k < 4; ++k)
+    {
+      const u32 r0 = rows[cy[0][k]], r1 = rows[cy[1][k]], c0 = columns[cx[0][k]], c1 = columns[cx[1][k]];
+      t[0][k] = texels[c0 + r0];
+      t[1][k] = texels[c1 + r0];
+      t[2][k] = texels[c0 + r1];
+      t[3][k] = texels[c1 + r1];
+    }
+
+    /* fx and fy are below 256 so a 16 bit multiply gives their 32 bit product */
+    const __m128i w11 = _mm_srli_epi32(_mm_add_epi32(_mm_mullo_epi16(fx, fy), half), 8);
+    const __m128i weights[4] = {
+      _mm_add_epi32(_mm_sub_epi32(_mm_sub_epi32(full, fx), fy), w11),
+      _mm_sub_epi32(fx, w11),
+      _mm_sub_epi32(fy, w11),
+      w11
+    };
+
+    /* weights add up to 256 so every partial sum of texel * weight fits 16 unsigned bits */
+    __m128i low = round, high = round;
+    for (size_t k = 0; k < 4; ++k)
+    {
+      const __m128i texel = _mm_load_si128(reinterpret_cast<const __m128i*>(t[k]));
+      __m128i weightLow, weightHigh;
+      expandWeights(weights[k], weightLow, weightHigh);
+
+      low = _mm_add_epi16(low, _mm_mullo_epi16(_mm_unpacklo_epi8(texel, zero), weightLow));
+      high = _mm_add_epi16(high, _mm_mullo_epi16(_mm_unpackhi_epi8(texel, zero), weightHigh));
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(colors + i), _mm_packus_epi16(_mm_srli_epi16(low, 8), _mm_srli_epi16(high, 8)));
+  }
+
+  scalar(texture, u + i, v + i, count - i, colors + i);
+}
+#endif
+
+bool sampler::isSupported(SamplerKernel kernel)
+{
+  switch (kernel)
+  {
+  case SamplerKernel::SCALAR: return true;
+#if A3D_X86
+  case SamplerKernel::SSE2: return SDL_HasSSE2();
+  case SamplerKernel::AVX2:
+  case SamplerKernel::AVX2_GATHER: return SDL_HasAVX2();
+#endif
+  default: return false;
+  }
+}
+
+SamplerKernel sampler::best()
+{
+  /* gathers aren't faster than separate loads on many cpus, so they're only used when asked for */
+  if (isSupported(SamplerKernel::AVX2))
+    return SamplerKernel::AVX2;
+  else if (isSupported(SamplerKernel::SSE2))
+    return SamplerKernel::SSE2;
+  else
+    return SamplerKernel::SCALAR;
+}
+
+bilinear_function_t sampler::function(SamplerKernel kernel)
+{
+  if (!isSupported(kernel))
+    return nullptr;
+
+  switch (kernel)
+  {
+#if A3D_X86
+  case SamplerKernel::SSE2: return &sse2;
+  case SamplerKernel::AVX2: return &avx2;
+  case SamplerKernel::AVX2_GATHER: return &avx2Gather;
+#endif
+  default: return &scalar;
+  }
+}
+
+const char* sampler::name(SamplerKernel kernel)
+{
+  switch (kernel)
+  {
+  case SamplerKernel::SCALAR: return "scalar";
+  case SamplerKernel::SSE2: return "sse2";
+  case SamplerKernel::AVX2: return "avx2";
+  case SamplerKernel::AVX2_GATHER: return "avx2 gather";
+  }
+
+  return "unknown";
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Texture.h"
+
+namespace a3d
+{
+  enum class SamplerKernel
+  {
+    SCALAR,
+    SSE2,
+    AVX2,
+    AVX2_GATHER
+  };
+
+  /* bilinear filters count fragments of a texture level at normalized coordinates (u[i], v[i]) and
+     writes their packed colors. Every kernel produces exactly the same colors as Texture::sampleBilinear,
+     SSE2 blends four fragments at once and AVX2 eight, loading texels one by one or with gathers */
+  using bilinear_function_t = void(*)(const Texture& texture, const float* u, const float* v, size_t count, u32* colors);
+
+  namespace sampler
+  {
+    void scalar(const Texture& texture, const float* u, const float* v, size_t count, u32* colors);
+#if A3D_X86
+    void sse2(const Texture& texture, const float* u, const float* v, size_t count, u32* colors);
+    void avx2(const Texture& texture, const float* u, const float* v, size_t count, u32* colors);
+    void avx2Gather(const Texture& texture, const float* u, const float* v, size_t count, u32* colors);
+#endif
+
+    bool isSupported(SamplerKernel kernel);
+    /* best kernel supported by the cpu we're running on */
+    SamplerKernel best();
+    bilinear_function_t function(SamplerKernel kernel);
+    const char* name(SamplerKernel kernel);
+  }
+}
@@ -0,0 +1,149 @@
+#include "Sampler.h"
+
+#if A3D_X86
+
+#include <immintrin.h>
+
+/* like CoverageAvx2.cpp this translation unit alone is compiled for AVX2, kernels are picked at
+   runtime only if the cpu supports them */
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+using namespace a3d;
+
+namespace
+{
+  struct coords_t
+  {
+    __m256i x0, x1, y0, y1;
+    __m256i weights[4];
+  };
+
+  /* clamped texel coordinates and bilinear weights of eight fragments, see Texture::sampleBilinear */
+  inline coords_t computeCoords(const Texture& texture, const float* u, const float* v)
+  {
+    const __m256 bias = _mm256_set1_ps(float(Texture::BILINEAR_BIAS * 256 - 128));
+    const __m256i unbias = _mm256_set1_epi32(Texture::BILINEAR_BIAS * 256);
+    const __m256i zero = _mm256_setzero_si256(), one = _mm256_set1_epi32(1), fraction = _mm256_set1_epi32(0xFF);
+    const __m256i maxX = _mm256_set1_epi32(int32_t(texture.width()) - 1), maxY = _mm256_set1_epi32(int32_t(texture.height()) - 1);
+
+    /* no fused multiply-add, it would round differently from the scalar path */
+    const __m256i x = _mm256_sub_epi32(_mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(u), _mm256_set1_ps(texture.width() * 256.0f)), bias)), unbias);
+    const __m256i y = _mm256_sub_epi32(_mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(v), _mm256_set1_ps(texture.height() * 256.0f)), bias)), unbias);
+
+    const __m256i fx = _mm256_and_si256(x, fraction), fy = _mm256_and_si256(y, fraction);
+    const __m256i x0 = _mm256_srai_epi32(x, 8), y0 = _mm256_srai_epi32(y, 8);
+
+    coords_t coords;
+    coords.x0 = _mm256_min_epi32(_mm256_max_epi32(x0, zero), maxX);
+    coords.x1 = _mm256_min_epi32(_mm256_max_epi32(_mm256_add_epi32(x0, one), zero), maxX);
+    coords.y0 = _mm256_min_epi32(_mm256_max_epi32(y0, zero), maxY);
+    coords.y1 = _mm256_min_epi32(_mm256_max_epi32(_mm256_add_epi32(y0, one), zero), maxY);
+
+    const __m256i w11 = _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi32(fx, fy), _mm256_set1_epi32(128)), 8);
+    coords.weights[0] = _mm256_add_epi32(_mm256_sub_epi32(_mm256_sub_epi32(_mm256_set1_epi32(256), fx), fy), w11);
+    coords.weights[1] = _mm256_sub_epi32(fx, w11);
+    coords.weights[2] = _mm256_sub_epi32(fy, w11);
+    coords.weights[3] = w11;
+
+    return coords;
+  }
+
+  /* weighted sum of the four texels of eight fragments. Unpacking works inside 128 bit lanes so the low
+     half holds fragments 0-1 and 4-5, the high one 2-3 and 6-7, packing puts them back in order */
+  inline __m256i blend(const __m256i texels[4], const __m256i weights[4])
+  {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i low = _mm256_set1_epi16(128), high = low;
+
+    for (size_t k = 0; k < 4; ++k)
+    {
+      const __m256i packed = _mm256_packs_epi32(weights[k], weights[k]);
+      const __m256i pairs = _mm256_unpacklo_epi16(packed, packed);
+
+      low = _mm256_add_epi16(low, _mm256_mullo_epi16(_mm256_unpacklo_epi8(texels[k], zero), _mm256_unpacklo_epi32(pairs, pairs)));
+      high = _mm256_add_epi16(high, _mm256_mullo_epi16(_mm256_unpackhi_epi8(texels[k], zero), _mm256_unpackhi_epi32(pairs, pairs)));
+    }
+
+    return _mm256_packus_epi16(_mm256_srli_epi16(low, 8), _mm256_srli_epi16(high, 8));
+  }
+}
+
+void sampler::avx2(const Texture& texture, const float* u, const float* v, size_t count, u32* colors)
+{
+  const u32* texels = texture.texels();
+  const u32* columns = texture.columnOffsets();
+  const u32* rows = texture.rowOffsets();
+
+  size_t i = 0;
+
+  for (; i + 8 <= count; i += 8)
+  {
+    const coords_t coords = computeCoords(texture, u + i, v + i);
+
+    alignas(32) u32 cx[2][8], cy[2][8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(cx[0]), coords.x0);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(cx[1]), coords.x1);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(cy[0]), coords.y0);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(cy[1]), coords.y1);
+
+    alignas(32) u32 t[4][8];
+    for (size_t k = 0; k < 8; ++k)
+    {
+      const u32 r0 = rows[cy[0][k]], r1 = rows[cy[1][k]], c0 = columns[cx[0][k]], c1 = columns[cx[1][k]];
+      t[0][k] = texels[c0 + r0];
+      t[1][k] = texels[c1 + r0];
+      t[2][k] = texels[c0 + r1];
+      t[3][k] = texels[c1 + r1];
+    }
+
+    const __m256i loaded[4] = {
+      _mm256_load_si256(reinterpret_cast<const __m256i*>(t[0])), _mm256_load_si256(reinterpret_cast<const __m256i*>(t[1])),
+      _mm256_load_si256(reinterpret_cast<const __m256i*>(t[2])), _mm256_load_si256(reinterpret_cast<const __m256i*>(t[3]))
+    };
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(colors + i), blend(loaded, coords.weights));
+  }
+
+  sse2(texture, u + i, v + i, count - i, colors + i);
+}
+
+void sampler::avx2Gather(const Texture& texture, const float* u, const float* v, size_t count, u32* colors)
+{
+  const int* texels = reinterpret_cast<const int*>(texture.texels());
+  const int* columns = reinterpret_cast<const int*>(texture.columnOffsets());
+  const int* rows = reinterpret_cast<const int*>(texture.rowOffsets());
+
+  size_t i = 0;
+
+  for (; i + 8 <= count; i += 8)
+  {
+    const coords_t coords = computeCoords(texture, u + i, v + i);
+
+    const __m256i c0 = _mm256_i32gather_epi32(columns, coords.x0, 4), c1 = _mm256_i32gather_epi32(columns, coords.x1, 4);
+    const __m256i r0 = _mm256_i32gather_epi32(rows, coords.y0, 4), r1 = _mm256_i32gather_epi32(rows, coords.y1, 4);
+
+    const __m256i loaded[4] = {
+      _mm256_i32gather_epi32(texels, _mm256_add_epi32(c0, r0), 4),
+      _mm256_i32gather_epi32(texels, _mm256_add_epi32(c1, r0), 4),
+      _mm256_i32gather_epi32(texels, _mm256_add_epi32(c0, r1), 4),
+      _mm256_i32gather_epi32(texels, _mm256_add_epi32(c1, r1), 4)
+    };
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(colors + i), blend(loaded, coords.weights));
+  }
+
+  sse2(texture, u + i, v + i, count - i, colors + i);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "Math.h"
+#include "VertexProcessor.h"
+
+#include <vector>
+
+#include "glm/ext/matrix_transform.hpp"
+
+namespace a3d
+{
+  class Camera
+  {
+  private:
+    mutable mat4 _transform;
+
+    vec2 _angle;
+    vec3 _position;
+    vec3 _target;
+
+  public:
+
+    void setPosition(const vec3& position) { _position = position; }
+    void setTarget(const vec3& target) { _target = target; }
+
+    const vec3& position() const { return _position; }
+    const vec3& target() const { return _target; }
+
+    const vec2 angle() const { return _angle; }
+    void rotate(const vec2& angle) { _angle += angle; }
+
+    vec3 directionUp() const { return vec3(_transform.inverse() * vec4(0, 1, 0, 0)); }
+    vec3 directionRight() const { return vec3(_transform.inverse() * vec4(1, 0, 0, 0)); }
+    vec3 directionForward() const { return vec3(_transform.inverse() * vec4(0, 0, -1, 0)); }
+
+    mat4 transform() const
+    {
+      //return glm::lookAt(_position, _target, vec3(0.0, -1.0, 0.0));
+      _transform = glm::mat4(1.0f);
+      _transform = glm::rotate(_transform, angle().x, glm::vec3(0, 1, 0));
+      _transform = glm::rotate(_transform, angle().y, glm::vec3(1, 0, 0));
+      _transform = glm::translate(_transform, -position());
+      return _transform;
+    }
+  };
+
+  class Object
+  {
+  protected:
+    vec3 _position;
+    vec3 _rotation;
+    vec3 _scale;
+
+  public:
+    Object() : _position(0, 0, 0), _rotation(0, 0, 0), _scale(1, 1, 1) { }
+
+    const vec3& position() const { return _position; }
+
+    const vec3& rotation() const { return _rotation; }
+    void setRotation(const vec3& rot) { _rotation = rot; }
+
+    const vec3& scale() const { return _scale; }
+    void setScale(const vec3 scale) { _scale = scale; }
+
+    mat4 transform() const
+    {
+      glm::mat4 modelMatrix = mat4(1.0f);
+      modelMatrix = glm::scale(modelMatrix, _scale);
+      modelMatrix = glm::translate(modelMatrix, _position);
+      modelMatrix = glm::rotate(modelMatrix, _rotation.x, glm::vec3(1.0f, 0.0f, 0.0f));
+      modelMatrix = glm::rotate(modelMatrix, _rotation.y, glm::vec3(0.0f, 1.0f, 0.0f));
+      modelMatrix = glm::rotate(modelMatrix, _rotation.z, glm::vec3(0.0f, 0.0f, 1.0f));
+      return modelMatrix;
+    }
+  };
+
+  class Quad : public Object
+  {
+  private:
+    std::array<vec3, 4> vertices;
+    std::array<vec2, 4> textureCoords;
+
+    /* both triangles wind counter clockwise around the normal (v2 - v0) x (v1 - v0), which for a quad
+       built from a corner and a size points towards -z */
+    std::array<u32, 6> indices = { { 0, 2, 1, 1, 2, 3 } };
+
+    Bounds _bounds;
+
+  public:
+    Quad() = default;
+
+    Quad(vec3&& v1, vec3&& v2, vec3&& v3, vec3&& v4) : vertices({ { v1, v2, v3, v4} })
+    {
+      _bounds = Bounds::of(vertices.data(), vertices.size());
+
+      textureCoords = {
+        vec2(0.0f, 0.0f),
+        vec2(64.0f / 384, 0.0f),
+        vec2(0.0f, 1.0f / 19),
+        vec2(64.0f / 384, 1.0f / 19)
+      };
+    }
+
+    Quad(vec3 v, float w, float h)
+    {
+      vertices = {
+        v,
+        vec3(v.x + w, v.y,     v.z),
+        vec3(v.x,     v.y + h, v.z),
+        vec3(v.x + w, v.y + h, v.z)
+      };
+
+      _bounds = Bounds::of(vertices.data(), vertices.size());
+
+      textureCoords = {
+        vec2(0.0f, 1.0f / 20),
+        vec2(64.0f / 384, 1.0f / 20),
+        vec2(0.0f, 0.0f),
+        vec2(64.0f / 384, 0.0f)
+      };
+
+      /*textureCoords = {
+        vec2(0.0f, 0.0f),
+        vec2(1.0f, 0.0f),
+        vec2(0.0f, 1.0f),
+        vec2(1.0f, 1.0f)
+      };*/
+    }
+
+    void setTextureCoords(vec2&& tl, vec2&& tr, vec2&& br, vec2&& bl)
+    {
+      textureCoords = { bl, br, tl, tr };
+    }
+
+    const auto& vertex(size_t i) const { return vertices[i]; }
+    const auto& textureCoord(size_t i) const { return textureCoords[i]; }
+
+    const Bounds& bounds() const { return _bounds; }
+
+    rasterize::IndexedGeometry geometry() const
+    {
+      return { vertices.data(), textureCoords.data(), vertices.size(), indices.data(), indices.size(), &_bounds };
+    }
+  };
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Common.h"
+#include "Profiler.h"
 
 #include "SDL.h"
 #include "SDL_image.h"
@@ -20,6 +21,11 @@ constexpr int32_t HEIGHT = 240;
 #define MOUSE_ENABLED true
 #endif
 
+/* the window shows the frame at its size unless a platform or the build asks for a scale */
+#if !defined(WINDOW_SCALE)
+#define WINDOW_SCALE 1
+#endif
+
 template<typename EventHandler, typename Renderer>
 class SDL
 {
@@ -114,17 +120,23 @@ void SDL<EventHandler, Renderer>::loop()
 {
   while (!willQuit)
   {
-#if defined(WINDOW_SCALE)
+#if WINDOW_SCALE != 1
     SDL_SetRenderTarget(_renderer, _canvas);
 #endif
     loopRenderer.render();
 
-#if defined(WINDOW_SCALE)
-    SDL_SetRenderTarget(_renderer, nullptr);
-    SDL_RenderCopy(_renderer, _canvas, nullptr, nullptr);
+    {
+      ProfileScope scope(Profiler::Stage::PRESENT);
+
+#if WINDOW_SCALE != 1
+      SDL_SetRenderTarget(_renderer, nullptr);
+      SDL_RenderCopy(_renderer, _canvas, nullptr, nullptr);
 #endif
 
-    SDL_RenderPresent(_renderer);
+      SDL_RenderPresent(_renderer);
+    }
+
+    Profiler::endFrame();
 
     handleEvents();
 
@@ -187,7 +199,7 @@ void SDL<EventHandler, Renderer>::handleEvents()
     case SDL_MOUSEBUTTONDOWN:
     case SDL_MOUSEBUTTONUP:
     case SDL_MOUSEMOTION:
-#if defined(WINDOW_SCALE)
+#if WINDOW_SCALE != 1
       event.button.x /= WINDOW_SCALE;
       event.button.y /= WINDOW_SCALE;
 #endif
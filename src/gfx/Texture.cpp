@@ -0,0 +1,132 @@
+#include "Texture.h"
+
+#include "ThreadPool.h"
+
+#include <cstring>
+
+using namespace a3d;
+
+namespace
+{
+  constexpr size_t ROWS_PER_TASK = 16;
+}
+
+Texture::Texture(const path& path) : Buffer2D(0, 0)
+{
+  if (!load(path))
+  {
+    _width = 1;
+    _height = 1;
+    _stride = 1;
+    _data.assign(1, pixels::pack(_format, 255, 0, 255, 255));
+    computeOffsets();
+  }
+}
+
+bool Texture::load(const path& path)
+{
+  SDL_Surface* image = IMG_Load(path.c_str());
+
+  if (!image)
+    return false;
+
+  const bool loaded = load(image);
+  SDL_FreeSurface(image);
+
+  return loaded;
+}
+
+bool Texture::load(SDL_Surface* image)
+{
+  /* images in one of our formats are converted while their rows are copied, others are converted by
+     SDL to the format of the texture first */
+  PixelFormat source;
+  const bool native = pixels::fromSdlFormat(image->format->format, source);
+  SDL_Surface* surface = native ? image : SDL_ConvertSurfaceFormat(image, pixels::sdlFormat(_format), 0);
+
+  if (!native)
+    source = _format;
+
+  if (!surface)
+    return false;
+
+  if (SDL_MUSTLOCK(surface))
+    SDL_LockSurface(surface);
+
+  const TexelLayout layout = _layout;
+
+  _width = surface->w;
+  _height = surface->h;
+  _layout = TexelLayout::LINEAR;
+  _stride = _width;
+  _data.resize(std::max<size_t>(_width * _height, 1));
+  _mips.clear();
+
+  for (size_t y = 0; y < _height; ++y)
+    pixels::convert(source, _format, reinterpret_cast<const u32*>(static_cast<const u8*>(surface->pixels) + y * surface->pitch), _data.data() + y * _width, _width);
+
+  if (SDL_MUSTLOCK(surface))
+    SDL_UnlockSurface(surface);
+
+  if (surface != image)
+    SDL_FreeSurface(surface);
+
+  computeOffsets();
+  setLayout(layout);
+
+  return true;
+}
+
+void Texture::generateMipmaps(ThreadPool* pool)
+{
+  size_t levels = 0;
+  for (size_t width = _width, height = _height; width > 1 || height > 1; width = std::max<size_t>(width / 2, 1), height = std::max<size_t>(height / 2, 1))
+    ++levels;
+
+  _mips.clear();
+  _mips.reserve(levels);
+
+  for (size_t i = 0; i < levels; ++i)
+  {
+    const Texture& source = level(i);
+    const size_t width = std::max<size_t>(source.width() / 2, 1), height = std::max<size_t>(source.height() / 2, 1);
+    const int32_t maxX = int32_t(source.width()) - 1, maxY = int32_t(source.height()) - 1;
+
+    std::vector<u32> texels(width * height);
+
+    /* average of the 2x2 source texels, the last row or column is repeated for odd sizes */
+    auto downsample = [&](size_t task, size_t) {
+      const size_t end = std::min((task + 1) * ROWS_PER_TASK, height);
+
+      for (size_t y = task * ROWS_PER_TASK; y < end; ++y)
+      {
+        const int32_t y0 = int32_t(y * 2), y1 = std::min(y0 + 1, maxY);
+
+        for (size_t x = 0; x < width; ++x)
+        {
+          const int32_t x0 = int32_t(x * 2), x1 = std::min(x0 + 1, maxX);
+          const u32 a = source.texel(x0, y0), b = source.texel(x1, y0), c = source.texel(x0, y1), d = source.texel(x1, y1);
+
+          u32 color = 0;
+          for (u32 shift = 0; shift < 32; shift += 8)
+            color |= ((((a >> shift) & 0xFF) + ((b >> shift) & 0xFF) + ((c >> shift) & 0xFF) + ((d >> shift) & 0xFF) + 2) / 4) << shift;
+
+          texels[y * width + x] = color;
+        }
+      }
+    };
+
+    const size_t tasks = (height + ROWS_PER_TASK - 1) / ROWS_PER_TASK;
+
+    if (pool)
+      pool->parallelFor(tasks, downsample);
+    else
+    {
+      for (size_t task = 0; task < tasks; ++task)
+        downsample(task, 0);
+    }
+
+    _mips.push_back(Texture(_format, width, height, std::move(texels)));
+    _mips.back().setLayout(_layout);
+  }
+}
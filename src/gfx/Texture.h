@@ -0,0 +1,307 @@
+#pragma once
+
+#include "Math.h"
+#include "PixelFormat.h"
+
+#include <cmath>
+#include <vector>
+
+#include "SDL.h"
+#include "SDL_image.h"
+
+class ThreadPool;
+
+namespace a3d
+{
+  template<typename T>
+  class Buffer2D
+  {
+  protected:
+    size_t _width;
+    size_t _height;
+    std::vector<T> _data;
+
+  public:
+    Buffer2D(size_t width, size_t height) : _width(width), _height(height), _data(width* height) { }
+    Buffer2D(size_t width, size_t height, T value) : _width(width), _height(height), _data(width* height, value) { }
+
+
+    T& get(int32_t x, int32_t y)
+    {
+      return x >= 0 && x < int32_t(_width) && y >= 0 && y < int32_t(_height) ? _data[y * _width + x] : _data[0];
+    }
+
+    const T& get(int32_t x, int32_t y) const
+    {
+      return x >= 0 && x < int32_t(_width) && y >= 0 && y < int32_t(_height) ? _data[y * _width + x] : _data[0];
+    }
+
+    T& get(const vec2& coords)
+    {
+      int32_t x = coords.x * _width;
+      int32_t y = coords.y * _height;
+      return get(x, y);
+    }
+
+    const T& get(const vec2& coords) const
+    {
+      int32_t x = coords.x * _width;
+      int32_t y = coords.y * _height;
+      return get(x, y);
+    }
+
+    /* unchecked access to the start of a row, used by the inner loops of the rasterizer */
+    T* row(size_t y) { return _data.data() + y * _width; }
+    const T* row(size_t y) const { return _data.data() + y * _width; }
+
+    T* data() { return _data.data(); }
+    const T* data() const { return _data.data(); }
+
+    size_t width() const { return _width; }
+    size_t height() const { return _height; }
+  };
+
+  /* order in which texels are stored in memory. LINEAR is plain row major, TILED stores 4x4 blocks
+     of texels contiguously so that a block fills exactly one cache line, MORTON stores 32x32 tiles
+     (a 4KB page each) with texels inside a tile in Z order. Swizzled layouts keep neighbours close
+     in every direction so rotated or minified sampling doesn't miss cache on every row step */
+  enum class TexelLayout { LINEAR, TILED, MORTON };
+
+  /* how levels of the mip chain are picked when sampling with a level of detail. NONE always samples
+     the base level, NEAREST the nearest texel of the closest level and LINEAR blends the bilinearly
+     filtered colors of the two closest levels (trilinear filtering) */
+  enum class MipFilter { NONE, NEAREST, LINEAR };
+
+  /* how texels inside a level are filtered, NEAREST picks the closest one, BILINEAR blends the four
+     closest ones */
+  enum class TextureFilter { NEAREST, BILINEAR };
+
+  /* texels are only reachable through texel() and sample(), which hide the address computation of
+     the current layout; storage is padded to whole blocks or tiles for swizzled layouts. Every layout
+     is separable so addresses are the sum of a column and a row offset, both kept in small tables
+     which makes sampling cost the same whatever the layout. Texels are packed in the pixel format
+     declared when the texture is created */
+  class Texture : protected Buffer2D<u32>
+  {
+  private:
+    static constexpr size_t BLOCK_SHIFT = 2;
+    static constexpr size_t TILE_SHIFT = 5;
+
+    PixelFormat _format = pixels::format();
+    TexelLayout _layout = TexelLayout::LINEAR;
+    size_t _stride = 0;
+
+    std::vector<u32> _columnOffsets;
+    std::vector<u32> _rowOffsets;
+
+    /* levels after the base one, each half the size of the previous, down to 1x1 */
+    std::vector<Texture> _mips;
+
+    /* level of the mip chain from row major texels */
+    Texture(PixelFormat format, size_t width, size_t height, std::vector<u32>&& texels) : Buffer2D(0, 0), _format(format), _stride(width)
+    {
+      _width = width;
+      _height = height;
+      _data = std::move(texels);
+      computeOffsets();
+    }
+
+    /* spreads the low 16 bits of value over the even bits of the result */
+    static u32 spreadBits(u32 value)
+    {
+      value = (value | (value << 8)) & 0x00FF00FF;
+      value = (value | (value << 4)) & 0x0F0F0F0F;
+      value = (value | (value << 2)) & 0x33333333;
+      value = (value | (value << 1)) & 0x55555555;
+      return value;
+    }
+
+    static size_t roundUp(size_t value, size_t shift) { return ((value + (size_t(1) << shift) - 1) >> shift) << shift; }
+
+    /* texels per row of blocks or tiles, or per row for LINEAR */
+    static size_t strideFor(TexelLayout layout, size_t width)
+    {
+      switch (layout)
+      {
+        case TexelLayout::TILED: return roundUp(width, BLOCK_SHIFT) >> BLOCK_SHIFT;
+        case TexelLayout::MORTON: return roundUp(width, TILE_SHIFT) >> TILE_SHIFT;
+        default: return width;
+      }
+    }
+
+    static size_t address(TexelLayout layout, size_t stride, u32 x, u32 y)
+    {
+      constexpr u32 BLOCK_MASK = (1 << BLOCK_SHIFT) - 1, TILE_MASK = (1 << TILE_SHIFT) - 1;
+
+      switch (layout)
+      {
+        case TexelLayout::TILED:
+          return (((y >> BLOCK_SHIFT) * stride + (x >> BLOCK_SHIFT)) << (2 * BLOCK_SHIFT)) + ((y & BLOCK_MASK) << BLOCK_SHIFT) + (x & BLOCK_MASK);
+        case TexelLayout::MORTON:
+          return (((y >> TILE_SHIFT) * stride + (x >> TILE_SHIFT)) << (2 * TILE_SHIFT)) + (spreadBits(x & TILE_MASK) | (spreadBits(y & TILE_MASK) << 1));
+        default:
+          return y * stride + x;
+      }
+    }
+
+    void computeOffsets()
+    {
+      _columnOffsets.resize(_width);
+      _rowOffsets.resize(_height);
+
+      for (u32 x = 0; x < _width; ++x)
+        _columnOffsets[x] = u32(address(_layout, _stride, x, 0));
+      for (u32 y = 0; y < _height; ++y)
+        _rowOffsets[y] = u32(address(_layout, _stride, 0, y));
+    }
+
+  public:
+    Texture(size_t width, size_t height) : Buffer2D(width, height), _stride(width)
+    {
+      const u32 light = pixels::pack(_format, 220, 220, 220, 255), dark = pixels::pack(_format, 120, 120, 120, 255);
+
+      for (size_t y = 0; y < _height; ++y)
+      {
+        for (size_t x = 0; x < _width; ++x)
+        {
+          auto cy = y / 16, cx = x / 16;
+
+          bool isDark = (cx % 2 == 1 && cy % 2 == 0) || (cx % 2 == 0 && cy % 2 == 1);
+
+          get(x, y) = isDark ? dark : light;
+        }
+      }
+
+      computeOffsets();
+    }
+
+    /* texture loaded from an image file, a missing or unreadable file gives a 1x1 magenta texture */
+    Texture(const path& path);
+
+    /* replaces the texels with the ones of an image file or surface, returns false if it can't be read.
+       The texel layout is kept while mipmaps need to be generated again */
+    bool load(const path& path);
+    bool load(SDL_Surface* surface);
+
+    using Buffer2D::width;
+    using Buffer2D::height;
+
+    PixelFormat format() const { return _format; }
+    TexelLayout layout() const { return _layout; }
+
+    /* reorders the texels in memory, sampling results are unaffected */
+    void setLayout(TexelLayout layout)
+    {
+      if (layout == _layout)
+        return;
+
+      const size_t stride = strideFor(layout, _width);
+      size_t size = _width * _height;
+
+      if (layout == TexelLayout::TILED)
+        size = roundUp(_width, BLOCK_SHIFT) * roundUp(_height, BLOCK_SHIFT);
+      else if (layout == TexelLayout::MORTON)
+        size = roundUp(_width, TILE_SHIFT) * roundUp(_height, TILE_SHIFT);
+
+      std::vector<u32> data(std::max<size_t>(size, 1));
+
+      for (u32 y = 0; y < _height; ++y)
+        for (u32 x = 0; x < _width; ++x)
+          data[address(layout, stride, x, y)] = texel(x, y);
+
+      _data = std::move(data);
+      _layout = layout;
+      _stride = stride;
+
+      computeOffsets();
+
+      for (auto& mip : _mips)
+        mip.setLayout(layout);
+    }
+
+    /* builds the mip chain with a box filter, levels are computed in parallel on the pool if present.
+       Textures which are modified afterwards need to generate it again */
+    void generateMipmaps(ThreadPool* pool = nullptr);
+
+    size_t levelCount() const { return _mips.size() + 1; }
+    const Texture& level(size_t index) const { return index == 0 ? *this : _mips[index - 1]; }
+
+    /* texel at integer coordinates, outside of the texture the first texel is returned */
+    const u32& texel(int32_t x, int32_t y) const
+    {
+      return x >= 0 && x < int32_t(_width) && y >= 0 && y < int32_t(_height) ? _data[_columnOffsets[x] + _rowOffsets[y]] : _data[0];
+    }
+
+    /* nearest texel to normalized coordinates */
+    const u32& sample(const vec2& coords) const
+    {
+      return texel(int32_t(coords.x * _width), int32_t(coords.y * _height));
+    }
+
+    /* bilinear filtering works on coordinates in 8 bit fixed point, biased by this many texels so that
+       truncating them is a floor also slightly outside of the texture */
+    static constexpr int32_t BILINEAR_BIAS = 1 << 14;
+
+    /* blend of the four texels closest to normalized coordinates, clamped to the edges. Weights are 8
+       bit fixed point so that vectorized samplers can reproduce the result exactly */
+    u32 sampleBilinear(const vec2& coords) const
+    {
+      const int32_t x = int32_t(coords.x * _width * 256.0f + float(BILINEAR_BIAS * 256 - 128)) - BILINEAR_BIAS * 256;
+      const int32_t y = int32_t(coords.y * _height * 256.0f + float(BILINEAR_BIAS * 256 - 128)) - BILINEAR_BIAS * 256;
+      const u32 fx = x & 0xFF, fy = y & 0xFF;
+
+      const int32_t maxX = int32_t(_width) - 1, maxY = int32_t(_height) - 1;
+      const int32_t x0 = std::min(std::max(x >> 8, 0), maxX), x1 = std::min(std::max((x >> 8) + 1, 0), maxX);
+      const int32_t y0 = std::min(std::max(y >> 8, 0), maxY), y1 = std::min(std::max((y >> 8) + 1, 0), maxY);
+
+      const u32 w11 = (fx * fy + 128) >> 8, w10 = fx - w11, w01 = fy - w11, w00 = 256 - fx - fy + w11;
+      const u32 t00 = texel(x0, y0), t10 = texel(x1, y0), t01 = texel(x0, y1), t11 = texel(x1, y1);
+
+      /* channels are blended the same whatever the format */
+      u32 color = 0;
+      for (u32 shift = 0; shift < 32; shift += 8)
+      {
+        const u32 channel = ((t00 >> shift) & 0xFF) * w00 + ((t10 >> shift) & 0xFF) * w10 + ((t01 >> shift) & 0xFF) * w01 + ((t11 >> shift) & 0xFF) * w11;
+        color |= ((channel + 128) >> 8) << shift;
+      }
+
+      return color;
+    }
+
+    /* picks the level to sample for a level of detail, which is log2 of the texels of the base level
+       covered by a pixel, and the weight (0 to 256) of the following level when blending them */
+    void selectLevel(float lod, MipFilter filter, size_t& index, u32& weight) const
+    {
+      const size_t last = _mips.size();
+      index = 0;
+      weight = 0;
+
+      if (filter == MipFilter::NEAREST)
+        index = std::min(size_t(std::max(lod + 0.5f, 0.0f)), last);
+      else if (filter == MipFilter::LINEAR && lod > 0.0f)
+      {
+        const float base = std::floor(lod);
+        index = std::min(size_t(base), last);
+        weight = index < last ? u32((lod - base) * 256.0f) : 0;
+      }
+    }
+
+    /* color at normalized coordinates for a level of detail */
+    u32 sample(const vec2& coords, float lod, MipFilter mipFilter, TextureFilter filter) const
+    {
+      size_t index;
+      u32 weight;
+      selectLevel(lod, mipFilter, index, weight);
+
+      auto filtered = [&](const Texture& level) -> u32 { return filter == TextureFilter::BILINEAR ? level.sampleBilinear(coords) : level.sample(coords); };
+
+      const u32 color = filtered(level(index));
+      return weight ? blendColors(color, filtered(level(index + 1)), weight) : color;
+    }
+
+    /* raw storage for vectorized samplers, the texel at (x, y) is texels()[columnOffsets()[x] + rowOffsets()[y]] */
+    const u32* texels() const { return _data.data(); }
+    const u32* columnOffsets() const { return _columnOffsets.data(); }
+    const u32* rowOffsets() const { return _rowOffsets.data(); }
+  };
+}
@@ -0,0 +1,46 @@
+#include "TextureCache.h"
+
+using namespace a3d;
+
+std::shared_ptr<const Texture> TextureCache::get(const path& path)
+{
+  std::lock_guard<std::mutex> lock(_lock);
+
+  auto it = _textures.find(path);
+
+  if (it != _textures.end())
+    return it->second;
+
+  auto texture = std::make_shared<Texture>(0, 0);
+
+  if (!texture->load(path))
+    return nullptr;
+
+  texture->setLayout(_layout);
+
+  if (_mipmaps)
+    texture->generateMipmaps(_pool);
+
+  _textures.emplace(path, texture);
+
+  return texture;
+}
+
+void TextureCache::collect()
+{
+  std::lock_guard<std::mutex> lock(_lock);
+
+  for (auto it = _textures.begin(); it != _textures.end(); )
+  {
+    if (it->second.use_count() == 1)
+      it = _textures.erase(it);
+    else
+      ++it;
+  }
+}
+
+size_t TextureCache::size() const
+{
+  std::lock_guard<std::mutex> lock(_lock);
+  return _textures.size();
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Texture.h"
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace a3d
+{
+  /* textures loaded from files, each file is decoded once and shared by everyone asking for the same
+     path. Textures are prepared on load with the layout and mipmaps set on the cache, and are immutable
+     afterwards since they can be shared */
+  class TextureCache
+  {
+  private:
+    ThreadPool* _pool;
+    TexelLayout _layout;
+    bool _mipmaps;
+
+    mutable std::mutex _lock;
+    std::unordered_map<path, std::shared_ptr<const Texture>> _textures;
+
+  public:
+    /* mipmaps are generated on the pool if present */
+    TextureCache(ThreadPool* pool = nullptr) : _pool(pool), _layout(TexelLayout::LINEAR), _mipmaps(false) { }
+
+    /* settings for textures loaded from now on */
+    void setLayout(TexelLayout layout) { _layout = layout; }
+    void setMipmaps(bool enabled) { _mipmaps = enabled; }
+
+    /* returns nullptr if the file can't be loaded, failures aren't cached so a later call tries again */
+    std::shared_ptr<const Texture> get(const path& path);
+
+    /* drops the textures nobody else is holding */
+    void collect();
+
+    size_t size() const;
+  };
+}
@@ -0,0 +1,269 @@
+#include "VertexProcessor.h"
+
+#include "Profiler.h"
+
+using namespace a3d;
+using namespace a3d::rasterize;
+
+namespace
+{
+  enum clip_plane_t : u8
+  {
+    CLIP_NEAR = 1 << 0,
+    CLIP_FAR = 1 << 1,
+    CLIP_LEFT = 1 << 2,
+    CLIP_RIGHT = 1 << 3,
+    CLIP_BOTTOM = 1 << 4,
+    CLIP_TOP = 1 << 5,
+
+    CLIP_PLANE_COUNT = 6
+  };
+
+  /* signed distance from a clip plane, non negative when inside. Near and far planes are the actual
+     frustum ones while the side planes are the guard band, not the viewport edges */
+  inline float distance(const vec4& p, u8 plane, const vec2& guard)
+  {
+    switch (plane)
+    {
+      case CLIP_NEAR: return p.z + p.w;
+      case CLIP_FAR: return p.w - p.z;
+      case CLIP_LEFT: return p.x + guard.x * p.w;
+      case CLIP_RIGHT: return guard.x * p.w - p.x;
+      case CLIP_BOTTOM: return p.y + guard.y * p.w;
+      default: return guard.y * p.w - p.y;
+    }
+  }
+
+  inline u8 outcode(const vec4& p, const vec2& guard)
+  {
+    u8 code = 0;
+
+    for (u8 i = 0; i < CLIP_PLANE_COUNT; ++i)
+    {
+      if (distance(p, u8(1 << i), guard) < 0.0f)
+        code |= u8(1 << i);
+    }
+
+    return code;
+  }
+
+  struct clip_vertex_t
+  {
+    vec4 position;
+    std::array<float, MAX_VARYINGS> varyings;
+  };
+
+  /* every plane adds at most a vertex to the polygon */
+  using clip_polygon_t = std::array<clip_vertex_t, 3 + CLIP_PLANE_COUNT>;
+
+  /* vertex where the edge from inside to outside crosses the plane. Edges are always interpolated
+     starting from the inside vertex so that an edge shared by two triangles is split at the same point */
+  inline clip_vertex_t intersect(const clip_vertex_t& inside, const clip_vertex_t& outside, float dInside, float dOutside, size_t varyingCount)
+  {
+    const float t = dInside / (dInside - dOutside);
+
+    clip_vertex_t vertex;
+    vertex.position = inside.position + (outside.position - inside.position) * t;
+
+    for (size_t v = 0; v < varyingCount; ++v)
+      vertex.varyings[v] = inside.varyings[v] + (outside.varyings[v] - inside.varyings[v]) * t;
+
+    return vertex;
+  }
+
+  /* Sutherland-Hodgman against a single plane, returns the amount of vertices in out */
+  size_t clip(const clip_polygon_t& in, size_t count, clip_polygon_t& out, u8 plane, const vec2& guard, size_t varyingCount)
+  {
+    size_t result = 0;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+      const clip_vertex_t& current = in[i];
+      const clip_vertex_t& next = in[(i + 1) % count];
+
+      const float dCurrent = distance(current.position, plane, guard);
+      const float dNext = distance(next.position, plane, guard);
+
+      if (dCurrent >= 0.0f)
+        out[result++] = current;
+
+      if ((dCurrent >= 0.0f) != (dNext >= 0.0f))
+      {
+        out[result++] = dCurrent >= 0.0f ?
+          intersect(current, next, dCurrent, dNext, varyingCount) :
+          intersect(next, current, dNext, dCurrent, varyingCount);
+      }
+    }
+
+    return result;
+  }
+}
+
+bool VertexProcessor::isBackFacing(const vec4* vertices, size_t count) const
+{
+  /* twice the signed area of the polygon, screen y grows downwards so counter clockwise ones are negative */
+  float area = 0.0f;
+  for (size_t i = 0, j = count - 1; i < count; j = i++)
+    area += vertices[j].x * vertices[i].y - vertices[i].x * vertices[j].y;
+
+  return _frontFace == Winding::COUNTER_CLOCKWISE ? area >= 0.0f : area <= 0.0f;
+}
+
+void VertexProcessor::draw(const mat4& mvp, const IndexedGeometry& geometry)
+{
+  ++_stats.objects;
+
+  ProfileScope vertexScope(Profiler::Stage::VERTEX);
+
+  Frustum::Test visibility = Frustum::Test::INTERSECTING;
+
+  if (_frustumCulling && geometry.bounds)
+  {
+    visibility = Frustum(mvp).test(*geometry.bounds);
+
+    if (visibility == Frustum::Test::OUTSIDE)
+    {
+      ++_stats.culledObjects;
+      _stats.triangles += geometry.indexCount / 3;
+      return;
+    }
+  }
+
+  _clip.resize(geometry.vertexCount);
+  _screen.resize(geometry.vertexCount);
+  _outcodes.resize(geometry.vertexCount);
+
+  const vec2 guard = _rasterizer->guardBand();
+
+  for (size_t i = 0; i < geometry.vertexCount; ++i)
+  {
+    _clip[i] = mvp * vec4(geometry.positions[i], 1.0f);
+    /* the guard band contains the frustum so nothing can be outside of it */
+    _outcodes[i] = visibility == Frustum::Test::INSIDE ? 0 : outcode(_clip[i], guard);
+
+    /* projecting is meaningless for vertices outside, the triangles using them go through clipping */
+    if (!_outcodes[i])
+      _screen[i] = _rasterizer->project(_clip[i]);
+  }
+
+  _stats.vertices += geometry.vertexCount;
+  vertexScope.stop();
+
+  /* assembly, clipping and triangle setup up to binning */
+  ProfileScope setupScope(Profiler::Stage::SETUP);
+
+  if (geometry.indexType == IndexType::U16)
+    drawTriangles(geometry, static_cast<const u16*>(geometry.indices));
+  else
+    drawTriangles(geometry, static_cast<const u32*>(geometry.indices));
+}
+
+template<typename I>
+void VertexProcessor::drawTriangles(const IndexedGeometry& geometry, const I* indexBuffer)
+{
+  Triangle triangle;
+  triangle.varyingCount = 2;
+
+  for (size_t i = 0; i + 2 < geometry.indexCount; i += 3)
+  {
+    const std::array<u32, 3> indices = { indexBuffer[i], indexBuffer[i + 1], indexBuffer[i + 2] };
+    assert(indices[0] < geometry.vertexCount && indices[1] < geometry.vertexCount && indices[2] < geometry.vertexCount);
+
+    ++_stats.triangles;
+
+    const u8 any = _outcodes[indices[0]] | _outcodes[indices[1]] | _outcodes[indices[2]];
+    const u8 all = _outcodes[indices[0]] & _outcodes[indices[1]] & _outcodes[indices[2]];
+
+    /* all the vertices outside of the same plane, nothing to draw */
+    if (all)
+    {
+      ++_stats.outside;
+      continue;
+    }
+    else if (any)
+    {
+      ++_stats.clipped;
+      clipAndDraw(indices, geometry, any);
+      continue;
+    }
+
+    for (size_t k = 0; k < 3; ++k)
+      triangle.vertices[k] = _screen[indices[k]];
+
+    if (_backFaceCulling && isBackFacing(triangle.vertices.data(), 3))
+    {
+      ++_stats.backFacing;
+      continue;
+    }
+
+    for (size_t k = 0; k < 3; ++k)
+    {
+      triangle.varyings[k][0] = geometry.textureCoords[indices[k]].x;
+      triangle.varyings[k][1] = geometry.textureCoords[indices[k]].y;
+    }
+
+    _rasterizer->draw(triangle);
+  }
+}
+
+void VertexProcessor::clipAndDraw(const std::array<u32, 3>& indices, const IndexedGeometry& geometry, u8 planes)
+{
+  const vec2 guard = _rasterizer->guardBand();
+  const size_t varyingCount = 2;
+
+  clip_polygon_t polygons[2];
+  size_t count = 3;
+
+  for (size_t k = 0; k < 3; ++k)
+  {
+    polygons[0][k].position = _clip[indices[k]];
+    polygons[0][k].varyings[0] = geometry.textureCoords[indices[k]].x;
+    polygons[0][k].varyings[1] = geometry.textureCoords[indices[k]].y;
+  }
+
+  /* only against the planes crossed by some vertex */
+  size_t current = 0;
+  for (u8 i = 0; i < CLIP_PLANE_COUNT && count >= 3; ++i)
+  {
+    if (planes & (1 << i))
+    {
+      count = clip(polygons[current], count, polygons[current ^ 1], u8(1 << i), guard, varyingCount);
+      current ^= 1;
+    }
+  }
+
+  if (count < 3)
+    return;
+
+  /* the clipped polygon is convex and planar, drawn as a fan around its first vertex */
+  const auto& polygon = polygons[current];
+
+  std::array<vec4, 3 + CLIP_PLANE_COUNT> screen;
+  for (size_t i = 0; i < count; ++i)
+    screen[i] = _rasterizer->project(polygon[i].position);
+
+  /* the whole polygon is tested since its first triangle could be degenerate */
+  if (_backFaceCulling && isBackFacing(screen.data(), count))
+  {
+    ++_stats.backFacing;
+    return;
+  }
+
+  Triangle triangle;
+  triangle.varyingCount = varyingCount;
+
+  auto set = [&](size_t k, size_t i) {
+    triangle.vertices[k] = screen[i];
+    for (size_t v = 0; v < varyingCount; ++v)
+      triangle.varyings[k][v] = polygon[i].varyings[v];
+  };
+
+  set(0, 0);
+
+  for (size_t i = 1; i + 1 < count; ++i)
+  {
+    set(1, i);
+    set(2, i + 1);
+    _rasterizer->draw(triangle);
+  }
+}
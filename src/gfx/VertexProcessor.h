@@ -0,0 +1,98 @@
+#pragma once
+
+#include "Rasterizer.h"
+
+#include <vector>
+
+namespace a3d
+{
+  namespace rasterize
+  {
+    enum class IndexType : u8
+    {
+      U16,
+      U32
+    };
+
+    /* an indexed triangle list, every index addresses a position and its texture coordinates */
+    struct IndexedGeometry
+    {
+      const vec3* positions;
+      const vec2* textureCoords;
+      size_t vertexCount;
+
+      const void* indices;
+      size_t indexCount;
+
+      /* bounds of the positions, if present the whole object can be culled against the frustum */
+      const Bounds* bounds;
+
+      IndexType indexType = IndexType::U32;
+    };
+
+    enum class Winding
+    {
+      CLOCKWISE,
+      COUNTER_CLOCKWISE
+    };
+
+    /* vertex stage in front of the rasterizer: each vertex of an object is transformed exactly once
+       into a buffer of transformed vertices, then triangles are assembled from the indices so that
+       vertices shared between triangles don't pay the transform again.
+
+       Triangles are clipped in homogeneous space against the near and far planes, while on the sides
+       they're clipped only if they leave the rasterizer guard band, which is rare.
+
+       Objects entirely outside of the frustum are skipped before transforming any vertex and
+       triangles facing away from the camera before they reach triangle setup */
+    class VertexProcessor
+    {
+    public:
+      struct Stats
+      {
+        u64 objects;
+        u64 culledObjects;
+        u64 vertices;
+        u64 triangles;
+        u64 backFacing;
+        u64 outside;
+        u64 clipped;
+
+        void reset() { *this = Stats(); }
+      };
+
+    private:
+      Rasterizer* _rasterizer;
+
+      /* kept between draws so that they don't allocate once grown to the largest object */
+      std::vector<vec4> _clip;
+      std::vector<vec4> _screen;
+      std::vector<u8> _outcodes;
+
+      Winding _frontFace;
+      bool _backFaceCulling;
+      bool _frustumCulling;
+
+      Stats _stats;
+
+      bool isBackFacing(const vec4* vertices, size_t count) const;
+      template<typename I> void drawTriangles(const IndexedGeometry& geometry, const I* indices);
+      void clipAndDraw(const std::array<u32, 3>& indices, const IndexedGeometry& geometry, u8 planes);
+
+    public:
+      VertexProcessor(Rasterizer* rasterizer) : _rasterizer(rasterizer), _frontFace(Winding::COUNTER_CLOCKWISE),
+        _backFaceCulling(true), _frustumCulling(true), _stats() { }
+
+      /* winding of front facing triangles as seen on screen */
+      void setFrontFace(Winding winding) { _frontFace = winding; }
+      void setBackFaceCulling(bool enabled) { _backFaceCulling = enabled; }
+      void setFrustumCulling(bool enabled) { _frustumCulling = enabled; }
+
+      const Stats& stats() const { return _stats; }
+      void resetStats() { _stats.reset(); }
+
+      /* mvp is the complete model-view-projection matrix of the object, computed once by the caller */
+      void draw(const mat4& mvp, const IndexedGeometry& geometry);
+    };
+  }
+}
@@ -1,19 +1,24 @@
 #include "ViewManager.h"
 
 #include "MainView.h"
+#include "PixelFormat.h"
 
 using namespace ui;
 
 ui::ViewManager::ViewManager() : SDL<ui::ViewManager, ui::ViewManager>(*this, *this), _font(nullptr),
-_mainView(new MainView(this))
+_mainView(nullptr), _view(nullptr)
 {
-  _view = _mainView;
 }
 
 void ui::ViewManager::deinit()
 {
   SDL_DestroyTexture(_font);
 
+  /* views own renderer resources so they must go before the renderer itself */
+  delete _mainView;
+  _mainView = nullptr;
+  _view = nullptr;
+
   SDL::deinit();
 }
 
@@ -27,6 +32,26 @@ bool ui::ViewManager::loadData()
   SDL_SetTextureBlendMode(_font, SDL_BLENDMODE_BLEND);
   SDL_FreeSurface(font);
 
+  /* targets and textures take the first format the renderer streams natively, they capture it when
+     they're created so the view can't exist before the renderer does */
+  SDL_RendererInfo info;
+  a3d::PixelFormat format;
+
+  if (SDL_GetRendererInfo(_renderer, &info) == 0)
+  {
+    for (Uint32 i = 0; i < info.num_texture_formats; ++i)
+    {
+      if (a3d::pixels::fromSdlFormat(info.texture_formats[i], format))
+      {
+        a3d::pixels::setFormat(format);
+        break;
+      }
+    }
+  }
+
+  _mainView = new MainView(this);
+  _view = _mainView;
+
   return true;
 }
 
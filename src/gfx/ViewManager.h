@@ -9,6 +9,8 @@ namespace ui
   class View
   {
   public:
+    virtual ~View() = default;
+
     virtual void render() = 0;
     virtual void handleKeyboardEvent(const SDL_Event& event) = 0;
     virtual void handleMouseEvent(const SDL_Event& event) = 0;
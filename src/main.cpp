@@ -1,7 +1,10 @@
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 
 #include "gfx/ViewManager.h"
+#include "bench/Bench.h"
+#include "Headless.h"
 
 
 #include <functional>
@@ -9,6 +12,13 @@
 
 int main(int argc, char* argv[])
 {
+  if (argc > 1 && strcmp(argv[1], "--bench") == 0)
+    return bench::run(argc - 2, argv + 2);
+  else if (argc > 1 && strcmp(argv[1], "--suite") == 0)
+    return bench::suite(argc - 2, argv + 2);
+  else if (argc > 1 && strcmp(argv[1], "--headless") == 0)
+    return headless::run(argc - 2, argv + 2);
+
   ui::ViewManager ui;
 
   if (!ui.init())